@@ -22,6 +22,7 @@ SOURCES += \
     APC/APC_Time.cpp \
     APC/APC_VecMat3D.cpp \
     logging/baselogger.cpp \
+    logging/binarystatelogger.cpp \
     logging/eventlogger.cpp \
     logging/loggingdialog.cpp \
     logging/statelogger.cpp \
@@ -31,14 +32,27 @@ SOURCES += \
     mainwindow/timers.cpp \
     mainwindow/tray.cpp \
     mainwindow.cpp \
+    models/qlogfilterproxy.cpp \
+    models/qlogmodel.cpp \
     models/qsightingmodel.cpp \
+    utils/almanac.cpp \
     utils/domestate.cpp \
+    utils/ephemeriscache.cpp \
     utils/exceptions.cpp \
     utils/formatters.cpp \
+    utils/gzip.cpp \
+    utils/heartbeatbuffer.cpp \
+    utils/heartbeatencoder.cpp \
+    utils/histogram.cpp \
+    utils/metrics.cpp \
+    utils/qmetricsserver.cpp \
     utils/qserialbuffer.cpp \
     utils/qserialportmanager.cpp \
+    utils/qstorageworker.cpp \
     utils/request.cpp \
+    utils/servertransport.cpp \
     utils/sighting.cpp \
+    utils/sightingjournal.cpp \
     utils/state/serialportstate.cpp \
     utils/state/state.cpp \
     utils/state/stationstate.cpp \
@@ -51,8 +65,10 @@ SOURCES += \
     widgets/lines/qdisplayline.cpp \
     widgets/lines/qfloatline.cpp \
     widgets/qaboutdialog.cpp \
+    widgets/qalmanacdialog.cpp \
     widgets/qcamera.cpp \
     widgets/qconfigurable.cpp \
+    widgets/qdiagnostics.cpp \
     widgets/qdome.cpp \
     widgets/qdomewidget.cpp \
     widgets/qserver.cpp \
@@ -80,20 +96,36 @@ HEADERS += \
     APC/APC_Time.h \
     APC/APC_VecMat3D.h \
     logging/baselogger.h \
+    logging/binarystatelogger.h \
+    logging/boundedqueue.h \
     logging/eventlogger.h \
     logging/include.h \
     logging/loggingdialog.h \
     logging/statelogger.h \
+    logging/staterecord.h \
     forward.h \
     mainwindow.h \
+    models/qlogfilterproxy.h \
+    models/qlogmodel.h \
     models/qsightingmodel.h \
+    utils/almanac.h \
     utils/domestate.h \
+    utils/ephemeriscache.h \
     utils/exceptions.h \
     utils/formatters.h \
+    utils/gzip.h \
+    utils/heartbeatbuffer.h \
+    utils/heartbeatencoder.h \
+    utils/histogram.h \
+    utils/metrics.h \
+    utils/qmetricsserver.h \
     utils/qserialbuffer.h \
     utils/qserialportmanager.h \
+    utils/qstorageworker.h \
     utils/request.h \
+    utils/servertransport.h \
     utils/sighting.h \
+    utils/sightingjournal.h \
     utils/state/serialportstate.h \
     utils/state/state.h \
     utils/state/stationstate.h \
@@ -106,8 +138,10 @@ HEADERS += \
     widgets/lines/qdisplayline.h \
     widgets/lines/qfloatline.h \
     widgets/qaboutdialog.h \
+    widgets/qalmanacdialog.h \
     widgets/qcamera.h \
     widgets/qconfigurable.h \
+    widgets/qdiagnostics.h \
     widgets/qdome.h \
     widgets/qdomewidget.h \
     widgets/qserver.h \
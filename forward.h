@@ -15,6 +15,9 @@ QT_FORWARD_DECLARE_CLASS(DomeStateZ);
 QT_FORWARD_DECLARE_CLASS(BaseLogger);
 QT_FORWARD_DECLARE_CLASS(EventLogger);
 QT_FORWARD_DECLARE_CLASS(StateLogger);
+QT_FORWARD_DECLARE_CLASS(QLogModel);
+QT_FORWARD_DECLARE_CLASS(QLogFilterProxy);
+QT_FORWARD_DECLARE_CLASS(QMetricsServer);
 
 QT_FORWARD_DECLARE_CLASS(QUfoManager);
 QT_FORWARD_DECLARE_CLASS(QStation);
@@ -1,12 +1,28 @@
+#include <algorithm>
+#include <QDebug>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QTimeZone>
+#include <QTextStream>
+#include <QMutexLocker>
+
 #include "logging/baselogger.h"
 #include "utils/exceptions.h"
+#include "utils/gzip.h"
 
 BaseLogger::BaseLogger(QObject * parent, const QString & filename):
     QObject(parent),
-    m_filename(filename)
-{}
+    m_filename(filename),
+    m_max_size(BaseLogger::DefaultMaxSize),
+    m_retention(BaseLogger::DefaultRetention)
+{
+    // One segment at a time, so that segments are indexed in the order they were closed
+    this->m_compressor.setMaxThreadCount(1);
+}
 
 BaseLogger::~BaseLogger(void) {
+    this->m_compressor.waitForDone();
     if (this->m_file != nullptr) {
         this->m_file->close();
         delete this->m_file;
@@ -19,13 +35,292 @@ void BaseLogger::initialize(void) {
     if (!QDir().mkpath(this->m_directory.path())) {
         throw ConfigurationError(QString("Could not create log folder %1").arg(this->m_directory.path()));
     }
+    if (!QDir().mkpath(this->archive_path())) {
+        throw ConfigurationError(QString("Could not create log archive folder %1").arg(this->archive_path()));
+    }
 
     if (!this->m_filename.isEmpty()) {
-        this->m_file = new QFile(QString("%1/%2").arg(this->m_directory.path(), this->m_filename));
-        this->m_file->open(QIODevice::Append | QIODevice::Text);
+        this->load_index();
+        this->recover_segments();
+
+        // Continue the file left by the previous run, its time range starts when it was created
+        const QFileInfo info(this->m_directory.filePath(this->m_filename));
+        const QDateTime now = QDateTime::currentDateTimeUtc();
+        QMutexLocker lock(&this->m_file_mutex);
+        if (info.exists() && (info.size() > 0)) {
+            this->open_segment((info.birthTime().isValid() ? info.birthTime() : info.lastModified()).toUTC());
+            this->m_last_write = info.lastModified().toUTC();
+            if (this->m_segment_start.date() != now.date()) {
+                this->rotate(now);
+            }
+        } else {
+            this->open_segment(now);
+        }
     }
 }
 
 QString BaseLogger::filename(void) const {
-    return this->m_file->fileName();
+    return this->m_directory.filePath(this->m_filename);
+}
+
+QString BaseLogger::archive_path(const QString & file) const {
+    const QString directory = this->m_directory.filePath(BaseLogger::ArchiveDirectory);
+    return file.isEmpty() ? directory : QString("%1/%2").arg(directory, file);
+}
+
+QString BaseLogger::index_path(void) const {
+    return this->archive_path(QString("%1.index").arg(QFileInfo(this->m_filename).completeBaseName()));
+}
+
+// Closed segments are named after the time they were started, e.g. events-20240131-221500-000.log
+QString BaseLogger::segment_name(const QDateTime & start) const {
+    const QFileInfo info(this->m_filename);
+    return QString("%1-%2.%3").arg(info.completeBaseName(), start.toString(BaseLogger::SegmentTimeFormat), info.suffix());
+}
+
+/**
+ * @brief BaseLogger::set_rotation
+ * @param max_size      size in bytes at which the active file is rolled over, 0 to roll over only daily
+ * @param retention     size in bytes of all closed segments together, 0 to keep them forever
+ */
+void BaseLogger::set_rotation(qint64 max_size, qint64 retention) {
+    {
+        QMutexLocker lock(&this->m_file_mutex);
+        this->m_max_size = max_size;
+    }
+    QMutexLocker lock(&this->m_index_mutex);
+    this->m_retention = retention;
+    this->enforce_retention();
+    this->save_index();
+}
+
+/**
+ * @brief BaseLogger::append
+ * Writes a block of already formatted lines to the active file, rolling it over first
+ * if the day has changed or if the block would not fit within the size limit.
+ * Safe to call from any thread.
+ */
+void BaseLogger::append(const QByteArray & data) {
+    QMutexLocker lock(&this->m_file_mutex);
+    if (this->m_file == nullptr) {
+        return;
+    }
+
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    const bool oversize = (this->m_max_size > 0) && (this->m_size > 0) && (this->m_size + data.size() > this->m_max_size);
+    if (oversize || (now.date() != this->m_segment_start.date())) {
+        this->rotate(now);
+    }
+
+    this->m_file->write(data);
+    this->m_file->flush();
+    // Approximate, text mode may translate line endings
+    this->m_size += data.size();
+    this->m_last_write = now;
+}
+
+// Must be called with m_file_mutex held
+void BaseLogger::open_segment(const QDateTime & start) {
+    this->m_file = new QFile(this->m_directory.filePath(this->m_filename));
+    this->m_file->open(QIODevice::Append | QIODevice::Text);
+    this->m_size = this->m_file->size();
+    this->m_segment_start = start;
+    this->m_last_write = start;
+}
+
+/**
+ * @brief BaseLogger::rotate
+ * Closes the active file, moves it to the archive and starts a new one.
+ * The closed segment is compressed and indexed by the compressor thread.
+ * Must be called with m_file_mutex held.
+ */
+void BaseLogger::rotate(const QDateTime & now) {
+    const QString active = this->m_file->fileName();
+    this->m_file->close();
+    delete this->m_file;
+    this->m_file = nullptr;
+
+    const QString archived = this->archive_path(this->segment_name(this->m_segment_start));
+    const bool moved = QFile::rename(active, archived);
+    if (moved) {
+        const Segment segment{this->m_segment_start, this->m_last_write, archived, 0};
+        this->m_compressor.start([this, archived, segment]() { this->compress(archived, segment); });
+    } else {
+        // Usually the file is held open by a viewer; keep writing to it and try again later
+        qWarning() << "Could not move" << active << "to" << archived;
+    }
+
+    this->open_segment(now);
+    if (!moved) {
+        this->m_size = 0;
+    }
+}
+
+/**
+ * @brief BaseLogger::compress
+ * Runs in the compressor thread: replaces a closed segment by its gzipped copy,
+ * adds it to the index and deletes the oldest segments that no longer fit the budget.
+ * If the compression fails, the uncompressed segment is indexed instead.
+ */
+void BaseLogger::compress(const QString & path, Segment segment) {
+    QByteArray compressed;
+    QFile source(path);
+    if (source.open(QIODevice::ReadOnly)) {
+        compressed = Gzip::compress(source.readAll());
+        source.close();
+    }
+
+    if (!compressed.isEmpty()) {
+        QSaveFile target(path + ".gz");
+        if (target.open(QIODevice::WriteOnly) && (target.write(compressed) == compressed.size()) && target.commit()) {
+            QFile::remove(path);
+            segment.file = target.fileName();
+        } else {
+            qWarning() << "Could not compress" << path << ":" << target.errorString();
+        }
+    }
+    segment.size = QFileInfo(segment.file).size();
+
+    QMutexLocker lock(&this->m_index_mutex);
+    auto position = std::upper_bound(this->m_segments.begin(), this->m_segments.end(), segment.first,
+                                     [](const QDateTime & first, const Segment & other) { return first < other.first; });
+    this->m_segments.insert(position, segment);
+    this->enforce_retention();
+    this->save_index();
+}
+
+/**
+ * @brief BaseLogger::recover_segments
+ * Picks up segments left behind by an interrupted run: uncompressed ones are compressed again,
+ * compressed ones missing from the index are added to it
+ */
+void BaseLogger::recover_segments(void) {
+    const QFileInfo info(this->m_filename);
+    const QString prefix = info.completeBaseName() + "-";
+    const QString suffix = "." + info.suffix();
+    const qsizetype stamp = QString(BaseLogger::SegmentTimeFormat).length();
+
+    QMutexLocker lock(&this->m_index_mutex);
+    QSet<QString> indexed;
+    for (const Segment & segment: std::as_const(this->m_segments)) {
+        indexed.insert(QFileInfo(segment.file).fileName());
+    }
+
+    const QFileInfoList files = QDir(this->archive_path()).entryInfoList({prefix + "*"}, QDir::Files, QDir::Name);
+    for (const QFileInfo & file: files) {
+        const bool compressed = file.fileName().endsWith(suffix + ".gz");
+        if ((!compressed && !file.fileName().endsWith(suffix)) || indexed.contains(file.fileName())) {
+            continue;
+        }
+
+        QDateTime first = QDateTime::fromString(file.fileName().mid(prefix.length(), stamp), BaseLogger::SegmentTimeFormat);
+        first.setTimeZone(QTimeZone::UTC);
+        if (!first.isValid()) {
+            continue;
+        }
+
+        const QString path = file.absoluteFilePath();
+        const Segment segment{first, file.lastModified().toUTC(), path, file.size()};
+        if (compressed) {
+            this->m_segments.append(segment);
+        } else if (QFile::exists(path + ".gz")) {
+            // Compressed completely but not yet deleted, the compressed copy is found next
+            QFile::remove(path);
+        } else {
+            // Waits for the index lock, so it is indexed only after this scan
+            this->m_compressor.start([this, path, segment]() { this->compress(path, segment); });
+        }
+    }
+
+    std::sort(this->m_segments.begin(), this->m_segments.end(),
+              [](const Segment & left, const Segment & right) { return left.first < right.first; });
+    this->save_index();
+}
+
+// Index lines are "first<TAB>last<TAB>size<TAB>file", file names are relative to the archive
+void BaseLogger::load_index(void) {
+    QFile file(this->index_path());
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return;
+    }
+
+    QMutexLocker lock(&this->m_index_mutex);
+    this->m_segments.clear();
+    QTextStream in(&file);
+    QString line;
+    while (in.readLineInto(&line)) {
+        const QStringList fields = line.split('\t');
+        if (fields.count() != 4) {
+            continue;
+        }
+
+        const Segment segment{
+            QDateTime::fromString(fields[0], Qt::ISODateWithMs),
+            QDateTime::fromString(fields[1], Qt::ISODateWithMs),
+            this->archive_path(fields[3]),
+            fields[2].toLongLong(),
+        };
+        if (segment.first.isValid() && segment.last.isValid() && QFile::exists(segment.file)) {
+            this->m_segments.append(segment);
+        }
+    }
+}
+
+// Must be called with m_index_mutex held, or before the compressor is started
+void BaseLogger::save_index(void) const {
+    QSaveFile file(this->index_path());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return;
+    }
+
+    QTextStream out(&file);
+    for (const Segment & segment: this->m_segments) {
+        out << segment.first.toString(Qt::ISODateWithMs) << '\t'
+            << segment.last.toString(Qt::ISODateWithMs) << '\t'
+            << segment.size << '\t'
+            << QFileInfo(segment.file).fileName() << '\n';
+    }
+    out.flush();
+    file.commit();
+}
+
+// Must be called with m_index_mutex held
+void BaseLogger::enforce_retention(void) {
+    if (this->m_retention <= 0) {
+        return;
+    }
+
+    qint64 total = 0;
+    for (const Segment & segment: std::as_const(this->m_segments)) {
+        total += segment.size;
+    }
+
+    while ((total > this->m_retention) && !this->m_segments.isEmpty()) {
+        const Segment oldest = this->m_segments.takeFirst();
+        QFile::remove(oldest.file);
+        total -= oldest.size;
+    }
+}
+
+/**
+ * @brief BaseLogger::segments
+ * Finds all segments, including the active file, that overlap the interval [from, to].
+ * Segments do not overlap each other, so the first candidate is found by a binary search.
+ */
+QVector<BaseLogger::Segment> BaseLogger::segments(const QDateTime & from, const QDateTime & to) const {
+    QVector<Segment> result;
+    {
+        QMutexLocker lock(&this->m_index_mutex);
+        auto segment = std::lower_bound(this->m_segments.cbegin(), this->m_segments.cend(), from,
+                                        [](const Segment & other, const QDateTime & time) { return other.last < time; });
+        for (; (segment != this->m_segments.cend()) && (segment->first <= to); ++segment) {
+            result.append(*segment);
+        }
+    }
+
+    QMutexLocker lock(&this->m_file_mutex);
+    if ((this->m_file != nullptr) && (this->m_segment_start <= to)) {
+        result.append(Segment{this->m_segment_start, QDateTime::currentDateTimeUtc(), this->m_file->fileName(), this->m_size});
+    }
+    return result;
 }
@@ -1,23 +1,80 @@
 #include <QObject>
 #include <QFile>
 #include <QDir>
+#include <QDateTime>
+#include <QMutex>
+#include <QThreadPool>
+#include <QVector>
 
 #ifndef BASELOGGER_H
 #define BASELOGGER_H
 
+/**
+ * @brief The BaseLogger class writes to a file that is rolled over when it grows past a size limit
+ *        or when the UTC day changes. Closed segments are moved to the archive directory,
+ *        compressed in the background and listed in an index of their time ranges;
+ *        the oldest segments are deleted once the archive exceeds the retention budget.
+ */
 class BaseLogger: public QObject {
     Q_OBJECT
+public:
+    struct Segment {
+        QDateTime first;
+        QDateTime last;
+        QString file;
+        qint64 size;
+    };
+
+    constexpr static qint64 DefaultMaxSize = 16 << 20;      // Size in bytes: roll over the file when it grows beyond this
+    constexpr static qint64 DefaultRetention = 512 << 20;   // Size in bytes: total size of the archive, 0 for unlimited
+
 protected:
     QString m_filename;
     QFile * m_file = nullptr;
     QDir m_directory;
 
+    void append(const QByteArray & data);
+
+private:
+    constexpr static char ArchiveDirectory[] = "logs";
+    constexpr static char SegmentTimeFormat[] = "yyyyMMdd-HHmmss-zzz";
+
+    // Guards the active file, writes may come from the writer thread
+    mutable QMutex m_file_mutex;
+    qint64 m_size = 0;
+    QDateTime m_segment_start;
+    QDateTime m_last_write;
+    qint64 m_max_size;
+
+    // Guards the segment index, which is updated by the compressor
+    mutable QMutex m_index_mutex;
+    QVector<Segment> m_segments;
+    qint64 m_retention;
+
+    QThreadPool m_compressor;
+
+    QString archive_path(const QString & file = QString()) const;
+    QString index_path(void) const;
+    QString segment_name(const QDateTime & start) const;
+
+    void open_segment(const QDateTime & start);
+    void rotate(const QDateTime & now);
+    void compress(const QString & path, Segment segment);
+    void recover_segments(void);
+
+    void load_index(void);
+    void save_index(void) const;
+    void enforce_retention(void);
+
 public:
     explicit BaseLogger(QObject * parent, const QString & filename);
     ~BaseLogger(void);
 
     void initialize(void);
     QString filename(void) const;
+
+    void set_rotation(qint64 max_size, qint64 retention);
+    QVector<Segment> segments(const QDateTime & from, const QDateTime & to) const;
 };
 
 #endif // BASELOGGER_H
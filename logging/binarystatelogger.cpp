@@ -0,0 +1,122 @@
+#include <QFileInfo>
+#include <QTimeZone>
+
+#include "logging/binarystatelogger.h"
+#include "logging/eventlogger.h"
+#include "utils/exceptions.h"
+
+extern EventLogger logger;
+
+
+BinaryStateLogger::BinaryStateLogger(QObject * parent, const QString & prefix):
+    QObject(parent),
+    m_prefix(prefix)
+{}
+
+BinaryStateLogger::~BinaryStateLogger(void) {
+    this->close();
+}
+
+void BinaryStateLogger::initialize(void) {
+    this->m_directory.setPath("./logs");
+
+    if (!QDir().mkpath(this->m_directory.path())) {
+        throw ConfigurationError(QString("Could not create log folder %1").arg(this->m_directory.path()));
+    }
+}
+
+QString BinaryStateLogger::filename(void) const {
+    return (this->m_file == nullptr) ? QString() : this->m_file->fileName();
+}
+
+void BinaryStateLogger::close(void) {
+    for (QFile ** file: {&this->m_file, &this->m_index}) {
+        if (*file != nullptr) {
+            (*file)->close();
+            delete *file;
+            *file = nullptr;
+        }
+    }
+}
+
+/**
+ * @brief BinaryStateLogger::open
+ * Opens the file for the month, writing the header if it is new. A record cut off by a crash
+ * is dropped, and index entries pointing beyond the end of the file are removed,
+ * so that appending continues from a consistent state.
+ */
+bool BinaryStateLogger::open(const QString & month) {
+    this->close();
+
+    const QString base = this->m_directory.filePath(QString("%1-%2").arg(this->m_prefix, month));
+    this->m_file = new QFile(base + ".bin");
+    this->m_index = new QFile(base + ".idx");
+
+    qint64 size = QFileInfo(this->m_file->fileName()).size();
+    if (size > 0) {
+        QFile existing(this->m_file->fileName());
+        char header[StateRecord::HeaderSize];
+        if (!existing.open(QIODevice::ReadOnly) ||
+            (existing.read(header, StateRecord::HeaderSize) != StateRecord::HeaderSize) ||
+            !StateRecord::check_header(header)) {
+            logger.error(Concern::Configuration, QString("Binary state log '%1' has an invalid header, not appending to it")
+                                                 .arg(this->m_file->fileName()));
+            this->close();
+            return false;
+        }
+    }
+
+    this->m_records = (size > StateRecord::HeaderSize) ? (size - StateRecord::HeaderSize) / StateRecord::RecordSize : 0;
+    const qint64 complete = StateRecord::HeaderSize + this->m_records * StateRecord::RecordSize;
+    if ((size > 0) && (size != complete)) {
+        logger.warning(Concern::Configuration, QString("Binary state log '%1' ends with a partial record, dropping it")
+                                               .arg(this->m_file->fileName()));
+        QFile::resize(this->m_file->fileName(), complete);
+    }
+
+    const qint64 entries = (this->m_records + StateRecord::IndexStride - 1) / StateRecord::IndexStride;
+    if (QFileInfo(this->m_index->fileName()).size() > entries * StateRecord::IndexEntrySize) {
+        QFile::resize(this->m_index->fileName(), entries * StateRecord::IndexEntrySize);
+    }
+
+    if (!this->m_file->open(QIODevice::Append) || !this->m_index->open(QIODevice::Append)) {
+        logger.error(Concern::Configuration, QString("Could not open binary state log '%1': %2")
+                                             .arg(this->m_file->fileName(), this->m_file->errorString()));
+        this->close();
+        return false;
+    }
+
+    if (size == 0) {
+        char header[StateRecord::HeaderSize];
+        StateRecord::encode_header(header);
+        this->m_file->write(header, StateRecord::HeaderSize);
+    }
+
+    return true;
+}
+
+void BinaryStateLogger::log(const StateRecord & record) {
+    const QString month = QDateTime::fromMSecsSinceEpoch(record.timestamp, QTimeZone::UTC).toString(BinaryStateLogger::MonthFormat);
+    if (month != this->m_month) {
+        // Tried only once per month, a broken file is not reported on every heartbeat
+        this->m_month = month;
+        this->open(month);
+    }
+    if (this->m_file == nullptr) {
+        return;
+    }
+
+    if (this->m_records % StateRecord::IndexStride == 0) {
+        char entry[StateRecord::IndexEntrySize];
+        qToLittleEndian<qint64>(record.timestamp, entry);
+        qToLittleEndian<qint64>(this->m_records, entry + 8);
+        this->m_index->write(entry, StateRecord::IndexEntrySize);
+        this->m_index->flush();
+    }
+
+    char buffer[StateRecord::RecordSize];
+    record.encode(buffer);
+    this->m_file->write(buffer, StateRecord::RecordSize);
+    this->m_file->flush();
+    this->m_records++;
+}
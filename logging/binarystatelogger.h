@@ -0,0 +1,42 @@
+#ifndef BINARYSTATELOGGER_H
+#define BINARYSTATELOGGER_H
+
+#include <QObject>
+#include <QFile>
+#include <QDir>
+#include <QDateTime>
+
+#include "logging/staterecord.h"
+
+/**
+ * @brief The BinaryStateLogger class appends fixed-width StateRecords to one file per month,
+ *        e.g. logs/state-202401.bin, with a sparse index in logs/state-202401.idx.
+ *        Months are never compressed, so that the files can be range-scanned in place;
+ *        a record takes 32 bytes, so a year of heartbeats every 15 s is about 70 MB.
+ *        See tools/statelog for the reader.
+ */
+class BinaryStateLogger: public QObject {
+    Q_OBJECT
+private:
+    constexpr static char MonthFormat[] = "yyyyMM";
+
+    QDir m_directory;
+    QString m_prefix;
+    QString m_month;
+    QFile * m_file = nullptr;
+    QFile * m_index = nullptr;
+    qint64 m_records = 0;
+
+    void close(void);
+    bool open(const QString & month);
+
+public:
+    explicit BinaryStateLogger(QObject * parent, const QString & prefix);
+    ~BinaryStateLogger(void);
+
+    void initialize(void);
+    void log(const StateRecord & record);
+    QString filename(void) const;
+};
+
+#endif // BINARYSTATELOGGER_H
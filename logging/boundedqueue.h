@@ -0,0 +1,94 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @brief The BoundedQueue class is a lock-free bounded multi-producer queue (Vyukov's algorithm).
+ *        Every cell carries a sequence number that tells producers and consumers whose turn it is,
+ *        so a push or pop is a single compare-and-swap on the shared position plus one release store.
+ *        When the queue is full, `try_push` fails immediately instead of blocking the producer.
+ */
+template<typename T, std::size_t Capacity>
+class BoundedQueue {
+    static_assert((Capacity >= 2) && ((Capacity & (Capacity - 1)) == 0), "Capacity must be a power of two");
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T data;
+    };
+
+    constexpr static std::size_t Mask = Capacity - 1;
+
+    std::array<Cell, Capacity> m_cells;
+    alignas(64) std::atomic<std::size_t> m_enqueue;
+    alignas(64) std::atomic<std::size_t> m_dequeue;
+
+public:
+    BoundedQueue(void):
+        m_enqueue(0),
+        m_dequeue(0)
+    {
+        for (std::size_t i = 0; i < Capacity; ++i) {
+            this->m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue & operator=(const BoundedQueue &) = delete;
+
+    bool try_push(T && value) {
+        std::size_t position = this->m_enqueue.load(std::memory_order_relaxed);
+        Cell * cell;
+        for (;;) {
+            cell = &this->m_cells[position & Mask];
+            const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+            if (difference == 0) {
+                if (this->m_enqueue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;   // full
+            } else {
+                position = this->m_enqueue.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(value);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T & value) {
+        std::size_t position = this->m_dequeue.load(std::memory_order_relaxed);
+        Cell * cell;
+        for (;;) {
+            cell = &this->m_cells[position & Mask];
+            const std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+            if (difference == 0) {
+                if (this->m_dequeue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;   // empty
+            } else {
+                position = this->m_dequeue.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->data);
+        cell->sequence.store(position + Mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate: counts a value that is still being pushed, but never misses one that was pushed
+    std::size_t size(void) const {
+        const std::size_t enqueue = this->m_enqueue.load(std::memory_order_relaxed);
+        const std::size_t dequeue = this->m_dequeue.load(std::memory_order_relaxed);
+        return (enqueue > dequeue) ? enqueue - dequeue : 0;
+    }
+};
+
+#endif // BOUNDEDQUEUE_H
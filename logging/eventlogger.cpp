@@ -1,9 +1,13 @@
+#include <atomic>
+
 #include "logging/eventlogger.h"
+#include "models/qlogmodel.h"
 
 
 EventLogger::EventLogger(QObject *parent, const QString &filename):
     BaseLogger(parent, filename),
-    logging_level(Level::Info),
+    logging_level(static_cast<int>(Level::Info)),
+    m_debug_mask(0),
     debug_visible({
         {Concern::Automatic,        true},
         {Concern::Configuration,    true},
@@ -14,8 +18,25 @@ EventLogger::EventLogger(QObject *parent, const QString &filename):
         {Concern::UFO,              true},
         {Concern::Operation,        true},
         {Concern::Storage,          true},
-    })
-{}
+    }),
+    m_stop(false),
+    m_sleeping(false),
+    m_queue(new BoundedQueue<LogRecord, EventLogger::QueueCapacity>()),
+    m_display_queue(new BoundedQueue<LogRecord, EventLogger::DisplayCapacity>()),
+    m_dropped(0),
+    m_dropped_display(0),
+    m_written(0)
+{
+    for (auto concern = this->debug_visible.cbegin(); concern != this->debug_visible.cend(); ++concern) {
+        this->set_debug_visible(concern.key(), concern.value());
+    }
+}
+
+EventLogger::~EventLogger(void) {
+    this->set_async(false);
+    delete this->m_queue;
+    delete this->m_display_queue;
+}
 
 const QMap<Level, LevelInfo> EventLogger::Levels = {
     {Level::DebugDetail,    {"DTL", "debug detail", Qt::gray}},
@@ -39,8 +60,8 @@ const QMap<Concern, ConcernInfo> EventLogger::Concerns = {
     {Concern::Storage,          {"STO", "storage",      "storage",          "Storage management"}}
 };
 
-void EventLogger::set_display_widget(QTableWidget * widget) {
-    this->m_display = widget;
+void EventLogger::set_display_model(QLogModel * model) {
+    this->m_display = model;
 }
 
 QString EventLogger::format(const QDateTime & timestamp, Level level, const QString & concern, const QString & message) const {
@@ -49,53 +70,167 @@ QString EventLogger::format(const QDateTime & timestamp, Level level, const QStr
 }
 
 void EventLogger::write(Level level, Concern concern, const QString & message) const {
-    if (level > this->logging_level) {
+    if (!this->is_active(level, concern)) {
         return;
     }
 
-    if ((level >= Level::DebugError) && (!this->debug_visible[concern])) {
+    LogRecord record{QDateTime::currentDateTimeUtc(), level, concern, message};
+
+    if (this->m_async) {
+        // Never block the caller: if the writer cannot keep up, drop the message and count it
+        if (this->m_queue->try_push(std::move(record))) {
+            this->wake_writer();
+        } else {
+            this->m_dropped++;
+        }
         return;
     }
 
-    QDateTime now = QDateTime::currentDateTimeUtc();
-    QString full = this->format(now, level, EventLogger::Concerns[concern].code, message);
-    QTextStream out(this->m_file);
-//    out.setCodec("UTF-8");
-
-    if (this->m_file != nullptr) {
-        out << full << Qt::endl;
+    // Synchronous mode touches the display model, which must only happen in the GUI thread
+    if (QThread::currentThread() != this->thread()) {
+        QMetaObject::invokeMethod(const_cast<EventLogger *>(this), [this, level, concern, message]() {
+            this->write(level, concern, message);
+        }, Qt::QueuedConnection);
+        return;
     }
 
+    const_cast<EventLogger *>(this)->append(this->line(record).toUtf8());
     if (this->m_display != nullptr) {
-        this->m_display->insertRow(this->m_display->rowCount());
+        this->m_display->append(record);
+    }
+}
+
+QString EventLogger::line(const LogRecord & record) const {
+    return this->format(record.timestamp, record.level, EventLogger::Concerns[record.concern].code, record.message) + '\n';
+}
+
+/**
+ * @brief EventLogger::set_async
+ * Switches between synchronous logging and the asynchronous mode with a background writer.
+ * Must be called from the GUI thread; switching off drains the queue first, and again once the writer
+ * has stopped, for records pushed by threads that had seen the asynchronous mode just before the switch.
+ */
+void EventLogger::set_async(bool async) {
+    if (async == this->m_async) {
+        return;
+    }
+
+    if (async) {
+        this->m_stop = false;
+        this->m_writer = QThread::create([this]() { this->run_writer(); });
+        this->m_writer->start();
+
+        if (this->m_display_timer == nullptr) {
+            this->m_display_timer = new QTimer(this);
+            this->m_display_timer->setInterval(EventLogger::DisplayInterval);
+            this->connect(this->m_display_timer, &QTimer::timeout, this, &EventLogger::refresh_display);
+        }
+        this->m_display_timer->start();
+        this->m_statistics_clock.start();
+        this->m_async = true;
+    } else {
+        this->m_async = false;
+        this->m_stop = true;
+        this->wake_writer();
+        this->m_writer->wait();
+        delete this->m_writer;
+        this->m_writer = nullptr;
+        this->drain();
+
+        if (this->m_display_timer != nullptr) {
+            this->m_display_timer->stop();
+        }
+        this->refresh_display();
+    }
+}
 
-        QTableWidgetItem *item_timestamp = new QTableWidgetItem(now.toString("yyyy-MM-dd hh:mm:ss.zzz"));
-        item_timestamp->setTextAlignment(Qt::AlignCenter);
-        this->m_display->setItem(this->m_display->rowCount() - 1, 0, item_timestamp);
+// Background writer: drains the queue in batches, one write and flush per batch
+void EventLogger::run_writer(void) {
+    QByteArray block;
+    LogRecord record;
 
-        QTableWidgetItem *item_level = new QTableWidgetItem(EventLogger::Levels[level].name);
-        item_level->setForeground(EventLogger::Levels[level].colour);
-        item_level->setTextAlignment(Qt::AlignCenter);
-        this->m_display->setItem(this->m_display->rowCount() - 1, 1, item_level);
+    for (;;) {
+        quint64 batch = 0;
+        block.clear();
+        while (this->m_queue->try_pop(record)) {
+            block.append(this->line(record).toUtf8());
+            if ((this->m_display != nullptr) && !this->m_display_queue->try_push(std::move(record))) {
+                this->m_dropped_display++;
+            }
+            batch++;
+        }
 
-        QTableWidgetItem *item_concern = new QTableWidgetItem(EventLogger::Concerns[concern].full_name);
-        item_concern->setForeground(EventLogger::Levels[level].colour);
-        item_concern->setTextAlignment(Qt::AlignCenter);
-        this->m_display->setItem(this->m_display->rowCount() - 1, 2, item_concern);
+        if (batch > 0) {
+            this->append(block);
+            this->m_written += batch;
+        } else if (this->m_stop) {
+            break;
+        } else {
+            // Announce the sleep before the last look at the queue, a producer then either sees it or has pushed already
+            QMutexLocker lock(&this->m_wake_mutex);
+            this->m_sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if ((this->m_queue->size() == 0) && !this->m_stop) {
+                this->m_wake.wait(&this->m_wake_mutex);
+            }
+            this->m_sleeping.store(false, std::memory_order_relaxed);
+        }
+    }
+}
 
-        QTableWidgetItem *item_message = new QTableWidgetItem(message);
-        item_message->setForeground(EventLogger::Levels[level].colour);
-        this->m_display->setItem(this->m_display->rowCount() - 1, 3, item_message);
+void EventLogger::wake_writer(void) const {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (this->m_sleeping.load(std::memory_order_relaxed) || this->m_stop) {
+        QMutexLocker lock(&this->m_wake_mutex);
+        this->m_wake.wakeOne();
+    }
+}
 
-        if (this->m_display->rowCount() > 256) {
-            this->m_display->removeRow(0);
+// Synchronous leftovers after the writer has stopped, in the GUI thread
+void EventLogger::drain(void) {
+    QByteArray block;
+    LogRecord record;
+    while (this->m_queue->try_pop(record)) {
+        block.append(this->line(record).toUtf8());
+        if (this->m_display != nullptr) {
+            this->m_display->append(record);
         }
-        this->m_display->scrollToBottom();
+        this->m_written++;
+    }
+    if (!block.isEmpty()) {
+        this->append(block);
     }
 }
 
+// Move whatever the writer has queued for display to the model as one batch
+void EventLogger::refresh_display(void) {
+    if (this->m_display != nullptr) {
+        QVector<LogRecord> batch;
+        LogRecord record;
+        while (this->m_display_queue->try_pop(record)) {
+            batch.append(std::move(record));
+        }
+        this->m_display->append(batch);
+    }
+
+    if (this->m_statistics_clock.isValid() && (this->m_statistics_clock.elapsed() >= EventLogger::StatisticsInterval)) {
+        emit this->statistics_updated("Event log", this->json());
+        this->m_statistics_clock.restart();
+    }
+}
+
+QJsonObject EventLogger::json(void) const {
+    return QJsonObject {
+        {"async", this->m_async.load()},
+        {"queued", static_cast<qint64>(this->m_queue->size())},
+        {"written", static_cast<qint64>(this->m_written.load())},
+        {"dropped", static_cast<qint64>(this->m_dropped.load())},
+        {"dropped_display", static_cast<qint64>(this->m_dropped_display.load())},
+    };
+}
+
 void EventLogger::set_level(Level new_level) {
-    this->logging_level = new_level;
+    this->logging_level = static_cast<int>(new_level);
 }
 
 void EventLogger::fatal(Concern concern, const QString & message) const { this->write(Level::Fatal, concern, message); }
@@ -108,6 +243,13 @@ void EventLogger::detail(Concern concern, const QString & message) const { this-
 
 void EventLogger::set_debug_visible(Concern concern, bool visible) {
     this->debug_visible[concern] = visible;
+
+    const quint32 bit = 1u << static_cast<unsigned int>(concern);
+    if (visible) {
+        this->m_debug_mask.fetch_or(bit);
+    } else {
+        this->m_debug_mask.fetch_and(~bit);
+    }
 }
 
 bool EventLogger::is_debug_visible(Concern concern) const {
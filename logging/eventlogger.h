@@ -3,13 +3,24 @@
 
 #include <QObject>
 #include <QDateTime>
-#include <QTableWidget>
+#include <QColor>
+#include <QVector>
 #include <QFile>
 #include <QDir>
 #include <QTextStream>
 #include <QSettings>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <atomic>
+#include <concepts>
+#include <functional>
 
 #include "logging/baselogger.h"
+#include "logging/boundedqueue.h"
 
 enum class Level {
     DebugDetail = 10,
@@ -46,25 +57,74 @@ struct ConcernInfo {
     QString caption;
 };
 
+struct LogRecord {
+    QDateTime timestamp;
+    Level level;
+    Concern concern;
+    QString message;
+};
+
+class QLogModel;
+
 class EventLogger: public BaseLogger {
     Q_OBJECT
 private:
-    QTableWidget * m_display = nullptr;
-    Level logging_level;
-
-    const static QMap<Level, LevelInfo> Levels;
+    QLogModel * m_display = nullptr;
+    // Read by every thread on every call, so kept atomic; the concern mask has one bit per Concern
+    std::atomic<int> logging_level;
+    std::atomic<quint32> m_debug_mask;
 
     QMap<Concern, bool> debug_visible;
 
+    // Asynchronous mode: records are queued by any thread, written by the writer thread
+    // and appended to the display model by the GUI thread at a limited rate
+    constexpr static std::size_t QueueCapacity = 8192;
+    constexpr static std::size_t DisplayCapacity = 1024;
+    constexpr static int DisplayInterval = 200;             // Time in ms: how often the display model is refreshed
+    constexpr static int StatisticsInterval = 5000;         // Time in ms: how often the statistics are published
+
+    std::atomic<bool> m_async = false;
+    std::atomic<bool> m_stop;
+    // The idle writer sleeps on m_wake, producers only take the mutex when it is actually asleep
+    std::atomic<bool> m_sleeping;
+    mutable QMutex m_wake_mutex;
+    mutable QWaitCondition m_wake;
+    QThread * m_writer = nullptr;
+    QTimer * m_display_timer = nullptr;
+    QElapsedTimer m_statistics_clock;
+    BoundedQueue<LogRecord, QueueCapacity> * m_queue;
+    BoundedQueue<LogRecord, DisplayCapacity> * m_display_queue;
+    mutable std::atomic<quint64> m_dropped;
+    std::atomic<quint64> m_dropped_display;
+    std::atomic<quint64> m_written;
+
     QString format(const QDateTime & timestamp, Level level, const QString & concern, const QString & message) const;
+    QString line(const LogRecord & record) const;
+    void run_writer(void);
+    void wake_writer(void) const;
+    void drain(void);
+
+private slots:
+    void refresh_display(void);
+
 public:
+    const static QMap<Level, LevelInfo> Levels;
     const static QMap<Concern, ConcernInfo> Concerns;
 
     explicit EventLogger(QObject * parent, const QString & filename);
+    ~EventLogger(void);
 
-    void set_display_widget(QTableWidget * widget);
+    void set_display_model(QLogModel * model);
     void set_level(Level new_level);
 
+    inline bool is_active(Level level, Concern concern) const {
+        if (static_cast<int>(level) > this->logging_level.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        return (level < Level::DebugError) ||
+               (this->m_debug_mask.load(std::memory_order_relaxed) & (1u << static_cast<unsigned int>(concern)));
+    }
+
     void write(Level level, Concern concern, const QString & message) const;
     void detail(Concern concern, const QString & message) const;
     void debug(Concern concern, const QString & message) const;
@@ -74,11 +134,35 @@ public:
     void error(Concern concern, const QString & message) const;
     void fatal(Concern concern, const QString & message) const;
 
+    // Lazy variants: the message is only formatted if it is going to be written,
+    // e.g. logger.debug(Concern::UFO, [&]{ return QString("...").arg(...); });
+    template<std::invocable Formatter>
+    inline void write(Level level, Concern concern, Formatter && formatter) const {
+        if (this->is_active(level, concern)) {
+            this->write(level, concern, QString(std::invoke(std::forward<Formatter>(formatter))));
+        }
+    }
+    template<std::invocable Formatter>
+    inline void detail(Concern concern, Formatter && formatter) const { this->write(Level::DebugDetail, concern, std::forward<Formatter>(formatter)); }
+    template<std::invocable Formatter>
+    inline void debug(Concern concern, Formatter && formatter) const { this->write(Level::Debug, concern, std::forward<Formatter>(formatter)); }
+    template<std::invocable Formatter>
+    inline void debug_error(Concern concern, Formatter && formatter) const { this->write(Level::DebugError, concern, std::forward<Formatter>(formatter)); }
+
     void set_debug_visible(Concern concern, bool visible);
     bool is_debug_visible(Concern concern) const;
 
     void load_settings(const QSettings * const settings);
     void save_settings(QSettings * settings) const;
+
+    void set_async(bool async);
+    inline bool is_async(void) const { return this->m_async; }
+    inline quint64 dropped(void) const { return this->m_dropped; }
+    inline quint64 dropped_display(void) const { return this->m_dropped_display; }
+    QJsonObject json(void) const;
+
+signals:
+    void statistics_updated(const QString & section, const QJsonObject & statistics);
 };
 
 #endif // LOG_H
@@ -7,13 +7,7 @@ QString StateLogger::format(const QDateTime & timestamp, const QString & message
     return QString("%1 %2").arg(timestamp.toString(Qt::ISODate), message);
 }
 
-void StateLogger::log(const QString & message) const {
+void StateLogger::log(const QString & message) {
     QDateTime now = QDateTime::currentDateTimeUtc();
-    QString full = this->format(now, message);
-    QTextStream out(this->m_file);
-    //out.setCodec("UTF-8");
-
-    if (this->m_file != nullptr) {
-        out << full << Qt::endl;
-    }
+    this->append((this->format(now, message) + '\n').toUtf8());
 }
@@ -13,7 +13,7 @@ private:
 public:
     explicit StateLogger(QObject * parent, const QString & filename);
 
-    void log(const QString & message) const;
+    void log(const QString & message);
 };
 
 #endif // STATELOGGER_H
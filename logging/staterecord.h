@@ -0,0 +1,112 @@
+#ifndef STATERECORD_H
+#define STATERECORD_H
+
+#include <cstring>
+#include <QtGlobal>
+#include <QtEndian>
+
+/**
+ * @brief The StateRecord struct is one fixed-width record of the binary state log.
+ *        A file starts with a header of HeaderSize bytes, followed by records of RecordSize bytes
+ *        in little endian, sorted by timestamp. Every IndexStride-th record is also listed
+ *        in the sidecar index as (timestamp, record number), so that a reader can seek
+ *        close to any time without scanning the file.
+ *        Only depends on QtCore, so that it is shared with the command-line reader.
+ *
+ *        offset  size  field
+ *             0     8  timestamp, ms since epoch, UTC
+ *             8     2  sun altitude, 0.1°
+ *            10     1  station state code
+ *            11     1  validity of the S, T and Z states (bits 0, 1, 2)
+ *            12     3  S state: basic, environment and error bytes
+ *            15     1  reserved
+ *            16     4  S state: time alive, s
+ *            20     8  T state: SHT31, lens and CPU temperature, 0.1 °C; humidity, 0.1 %
+ *            28     2  Z state: shaft position
+ *            30     2  reserved
+ */
+struct StateRecord {
+    constexpr static char Magic[8] = {'A', 'M', 'O', 'S', 'S', 'T', 'A', 'T'};
+    constexpr static quint16 Version = 1;
+    constexpr static qint64 HeaderSize = 16;
+    constexpr static qint64 RecordSize = 32;
+    constexpr static qint64 IndexEntrySize = 16;
+    constexpr static qint64 IndexStride = 256;
+
+    constexpr static quint8 ValidS = 0x01;
+    constexpr static quint8 ValidT = 0x02;
+    constexpr static quint8 ValidZ = 0x04;
+
+    qint64 timestamp = 0;
+    qint16 sun_altitude = 0;
+    char state = '?';
+    quint8 valid = 0;
+    quint8 basic = 0;
+    quint8 env = 0;
+    quint8 errors = 0;
+    quint32 time_alive = 0;
+    qint16 temperature_sht = 0;
+    qint16 temperature_lens = 0;
+    qint16 temperature_cpu = 0;
+    qint16 humidity = 0;
+    qint16 shaft_position = 0;
+
+    // Values are stored in tenths
+    static inline qint16 deci(double value) { return static_cast<qint16>(qRound(qBound(-3276.8, value, 3276.7) * 10.0)); }
+    static inline double undeci(qint16 value) { return value / 10.0; }
+
+    static inline void encode_header(char * buffer) {
+        std::memset(buffer, 0, StateRecord::HeaderSize);
+        std::memcpy(buffer, StateRecord::Magic, sizeof(StateRecord::Magic));
+        qToLittleEndian<quint16>(StateRecord::Version, buffer + 8);
+        qToLittleEndian<quint16>(static_cast<quint16>(StateRecord::RecordSize), buffer + 10);
+    }
+
+    static inline bool check_header(const char * buffer) {
+        return (std::memcmp(buffer, StateRecord::Magic, sizeof(StateRecord::Magic)) == 0) &&
+               (qFromLittleEndian<quint16>(buffer + 8) == StateRecord::Version) &&
+               (qFromLittleEndian<quint16>(buffer + 10) == StateRecord::RecordSize);
+    }
+
+    inline void encode(char * buffer) const {
+        qToLittleEndian<qint64>(this->timestamp, buffer);
+        qToLittleEndian<qint16>(this->sun_altitude, buffer + 8);
+        buffer[10] = this->state;
+        buffer[11] = static_cast<char>(this->valid);
+        buffer[12] = static_cast<char>(this->basic);
+        buffer[13] = static_cast<char>(this->env);
+        buffer[14] = static_cast<char>(this->errors);
+        buffer[15] = 0;
+        qToLittleEndian<quint32>(this->time_alive, buffer + 16);
+        qToLittleEndian<qint16>(this->temperature_sht, buffer + 20);
+        qToLittleEndian<qint16>(this->temperature_lens, buffer + 22);
+        qToLittleEndian<qint16>(this->temperature_cpu, buffer + 24);
+        qToLittleEndian<qint16>(this->humidity, buffer + 26);
+        qToLittleEndian<qint16>(this->shaft_position, buffer + 28);
+        qToLittleEndian<quint16>(0, buffer + 30);
+    }
+
+    static inline StateRecord decode(const char * buffer) {
+        StateRecord record;
+        record.timestamp = qFromLittleEndian<qint64>(buffer);
+        record.sun_altitude = qFromLittleEndian<qint16>(buffer + 8);
+        record.state = buffer[10];
+        record.valid = static_cast<quint8>(buffer[11]);
+        record.basic = static_cast<quint8>(buffer[12]);
+        record.env = static_cast<quint8>(buffer[13]);
+        record.errors = static_cast<quint8>(buffer[14]);
+        record.time_alive = qFromLittleEndian<quint32>(buffer + 16);
+        record.temperature_sht = qFromLittleEndian<qint16>(buffer + 20);
+        record.temperature_lens = qFromLittleEndian<qint16>(buffer + 22);
+        record.temperature_cpu = qFromLittleEndian<qint16>(buffer + 24);
+        record.humidity = qFromLittleEndian<qint16>(buffer + 26);
+        record.shaft_position = qFromLittleEndian<qint16>(buffer + 28);
+        return record;
+    }
+
+    static inline qint64 decode_timestamp(const char * buffer) {
+        return qFromLittleEndian<qint64>(buffer);
+    }
+};
+
+#endif // STATERECORD_H
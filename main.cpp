@@ -1,12 +1,16 @@
 #include "mainwindow.h"
 #include "logging/eventlogger.h"
 #include "logging/statelogger.h"
+#include "utils/metrics.h"
+#include "utils/ephemeriscache.h"
 
 #include <QApplication>
 #include "utils/state/serialportstate.h"
 
 
 MainWindow * main_window;
+Metrics metrics;
+EphemerisCache ephemeris;
 EventLogger logger(main_window, "events.log");
 QSettings * settings;
 
@@ -1,9 +1,15 @@
+#include <QThreadPool>
+
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 
 #include "logging/loggingdialog.h"
 #include "widgets/qaboutdialog.h"
 #include "models/qsightingmodel.h"
+#include "models/qlogmodel.h"
+#include "models/qlogfilterproxy.h"
+#include "widgets/qdiagnostics.h"
+#include "utils/qmetricsserver.h"
 
 extern EventLogger logger;
 extern QSettings * settings;
@@ -11,15 +17,14 @@ extern QSettings * settings;
 MainWindow::MainWindow(QWidget *parent):
     QMainWindow(parent),
     ui(new Ui::MainWindow),
-    m_terminate(false)
+    m_terminate(false),
+    m_log_follow(true)
 {
     this->ui->setupUi(this);
 
-    this->ui->tb_log->setColumnWidth(0, 140);
-    this->ui->tb_log->setColumnWidth(1, 72);
-    this->ui->tb_log->setColumnWidth(2, 80);
-
-    logger.set_display_widget(this->ui->tb_log);
+    this->create_log_view();
+    this->create_metrics_server();
+    logger.set_display_model(this->m_log_model);
     logger.info(Concern::Operation, QString("------------ Initializing AMOS client %1 ------------").arg(VERSION_STRING));
 
     // connect signals for handling of edits of station position
@@ -84,8 +89,13 @@ MainWindow::MainWindow(QWidget *parent):
     this->connect(model, &QSightingModel::sighting_accepted, this->ui->camera_spectral, &QCamera::store_sighting);
     this->connect(model, &QSightingModel::sighting_rejected, this->ui->camera_allsky,   &QCamera::discard_sighting);
     this->connect(model, &QSightingModel::sighting_rejected, this->ui->camera_spectral, &QCamera::discard_sighting);
+    this->connect(model, &QSightingModel::cleared, this->ui->camera_allsky, &QCamera::rescan_sightings);
+    this->connect(model, &QSightingModel::cleared, this->ui->camera_spectral, &QCamera::rescan_sightings);
 
     this->connect(this->ui->server->timer_heartbeat(), &QTimer::timeout, this->ui->station, &QStation::send_heartbeat);
+    this->connect(this->ui->dome, &QDome::link_statistics_updated, this->ui->diagnostics, &QDiagnostics::display);
+    this->connect(&logger, &EventLogger::statistics_updated, this->ui->diagnostics, &QDiagnostics::display);
+    this->connect(this->ui->server->transport(), &ServerTransport::statistics_updated, this->ui->diagnostics, &QDiagnostics::display);
 
     this->connect(this->ui->dome, &QAmosWidget::settings_changed, this, &MainWindow::slot_settings_changed);
     this->connect(this->ui->station, &QAmosWidget::settings_changed, this, &MainWindow::slot_settings_changed);
@@ -111,6 +121,12 @@ MainWindow::MainWindow(QWidget *parent):
 
 MainWindow::~MainWindow() {
     logger.info(Concern::Operation, "Terminating normally");
+    this->m_metrics_thread->quit();
+    this->m_metrics_thread->wait();
+    this->m_timer_ephemeris->stop();
+    QThreadPool::globalInstance()->waitForDone();
+    logger.set_async(false);
+    logger.set_display_model(nullptr);
 
     delete this->ui;
     delete this->m_timer_display;
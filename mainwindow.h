@@ -9,6 +9,7 @@
 #include <QCloseEvent>
 #include <QDesktopServices>
 #include <QIcon>
+#include <QThread>
 
 #include "forward.h"
 #include "widgets/qconfigurable.h"
@@ -30,8 +31,16 @@ public:
     ~MainWindow();
 
 private:
+    constexpr static int MetricsInterval = 15000;   // Time in ms: how often the metrics file is rewritten
+    constexpr static char MetricsFile[] = "metrics.prom";
+
     QTimer * m_timer_display;
     QTimer * m_timer_long;
+    QTimer * m_timer_metrics;
+    QTimer * m_timer_ephemeris;
+    QThread * m_metrics_thread;
+    QMetricsServer * m_metrics_server;
+    void create_metrics_server(void);
     Ui::MainWindow * ui;
 
     QAction * minimizeAction;
@@ -49,11 +58,18 @@ private:
 
     QVector<QAmosWidget *> amos_widgets;
 
+    QLogModel * m_log_model;
+    QLogFilterProxy * m_log_filter;
+    bool m_log_follow;
+    void create_log_view(void);
+
 private slots:
     void load_settings(void);
 
     void create_timers(void);
     void process_display_timer(void);
+    void write_metrics(void);
+    void refresh_ephemeris(void);
 
     // Settings
     void slot_settings_changed(void);
@@ -62,6 +78,7 @@ private slots:
     void on_cb_debug_stateChanged(int debug);
     void display_time(void);
     void display_window_title(void);
+    void apply_log_filter(void);
 
     // Tray and messaging
     void set_icon(const StationState & state);
@@ -1,7 +1,13 @@
+#include <QScrollBar>
+
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 
 #include "utils/formatters.h"
+#include "models/qlogmodel.h"
+#include "models/qlogfilterproxy.h"
+
+extern EventLogger logger;
 
 
 void MainWindow::display_time(void) {
@@ -26,3 +32,51 @@ void MainWindow::display_window_title(void) {
          this->ui->station->is_safety_overridden() ? " [safety override]" : ""
     ));
 }
+
+/**
+ * @brief MainWindow::create_log_view
+ * Sets up the log table over the filtered ring model. The table follows new records
+ * only while it is scrolled to the bottom, so that older records can be read undisturbed.
+ */
+void MainWindow::create_log_view(void) {
+    this->m_log_model = new QLogModel(this);
+    this->m_log_filter = new QLogFilterProxy(this);
+    this->m_log_filter->setSourceModel(this->m_log_model);
+
+    this->ui->tb_log->setModel(this->m_log_filter);
+    this->ui->tb_log->setColumnWidth(QLogModel::TimestampColumn, 140);
+    this->ui->tb_log->setColumnWidth(QLogModel::LevelColumn, 72);
+    this->ui->tb_log->setColumnWidth(QLogModel::ConcernColumn, 80);
+    this->ui->tb_log->verticalHeader()->setSectionResizeMode(QHeaderView::ResizeMode::Fixed);
+
+    for (auto level = EventLogger::Levels.cbegin(); level != EventLogger::Levels.cend(); ++level) {
+        this->ui->cb_log_level->addItem(level.value().name, static_cast<int>(level.key()));
+    }
+    this->ui->cb_log_level->setCurrentIndex(this->ui->cb_log_level->count() - 1);
+
+    this->ui->cb_log_concern->addItem("all concerns", QLogFilterProxy::AllConcerns);
+    for (auto concern = EventLogger::Concerns.cbegin(); concern != EventLogger::Concerns.cend(); ++concern) {
+        this->ui->cb_log_concern->addItem(concern.value().full_name, 1u << static_cast<unsigned int>(concern.key()));
+    }
+
+    this->connect(this->ui->cb_log_level, &QComboBox::currentIndexChanged, this, &MainWindow::apply_log_filter);
+    this->connect(this->ui->cb_log_concern, &QComboBox::currentIndexChanged, this, &MainWindow::apply_log_filter);
+    this->connect(this->ui->le_log_search, &QLineEdit::textChanged, this, &MainWindow::apply_log_filter);
+
+    this->connect(this->m_log_filter, &QAbstractItemModel::rowsAboutToBeInserted, this, [this]() {
+        const QScrollBar * bar = this->ui->tb_log->verticalScrollBar();
+        this->m_log_follow = (bar->value() == bar->maximum());
+    });
+    this->connect(this->m_log_filter, &QAbstractItemModel::rowsInserted, this, [this]() {
+        if (this->m_log_follow) {
+            this->ui->tb_log->scrollToBottom();
+        }
+    });
+}
+
+void MainWindow::apply_log_filter(void) {
+    this->m_log_filter->set_level(static_cast<Level>(this->ui->cb_log_level->currentData().toInt()));
+    this->m_log_filter->set_concern_mask(this->ui->cb_log_concern->currentData().toUInt());
+    this->m_log_filter->set_search(this->ui->le_log_search->text());
+    this->ui->tb_log->scrollToBottom();
+}
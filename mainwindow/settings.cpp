@@ -2,10 +2,14 @@
 #include "ui_mainwindow.h"
 
 #include "utils/exceptions.h"
+#include "models/qlogmodel.h"
+#include "utils/qmetricsserver.h"
+#include "utils/ephemeriscache.h"
 
 
 extern EventLogger logger;
 extern QSettings * settings;
+extern EphemerisCache ephemeris;
 
 void MainWindow::load_settings(void) {
     try {
@@ -16,6 +20,31 @@ void MainWindow::load_settings(void) {
         this->ui->station->set_dome(this->ui->dome);
 
         logger.load_settings(settings);
+        logger.set_async(settings->value("logging/async", true).toBool());
+        logger.set_rotation(
+            settings->value("logging/max_size", BaseLogger::DefaultMaxSize).toLongLong(),
+            settings->value("logging/retention", BaseLogger::DefaultRetention).toLongLong()
+        );
+        this->m_log_model->set_capacity(settings->value("logging/history", QLogModel::DefaultCapacity).toInt());
+
+        // Optional local metrics endpoint, loopback only unless configured otherwise
+        if (settings->value("metrics/enabled", false).toBool()) {
+            const QString host = settings->value("metrics/address", QMetricsServer::DefaultAddress).toString();
+            const QHostAddress address(host);
+            const quint16 port = settings->value("metrics/port", QMetricsServer::DefaultPort).toUInt();
+            if (address.isNull()) {
+                logger.error(Concern::Configuration, QString("Invalid metrics endpoint address \"%1\"").arg(host));
+            } else {
+                QMetricsServer * server = this->m_metrics_server;
+                QMetaObject::invokeMethod(server, [server, address, port]() { server->listen(address, port); }, Qt::QueuedConnection);
+            }
+        }
+
+        // Ephemeris cache, the error bound is in arcseconds
+        ephemeris.configure(
+            settings->value("ephemeris/cache", true).toBool(),
+            settings->value("ephemeris/max_error", EphemerisCache::DefaultMaxError).toDouble()
+        );
 
         // Load and set debug levels
         bool debug = settings->value("debug", false).toBool();
@@ -1,5 +1,15 @@
+#include <QThreadPool>
+
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "widgets/qdiagnostics.h"
+#include "utils/metrics.h"
+#include "utils/qmetricsserver.h"
+#include "utils/ephemeriscache.h"
+
+extern EventLogger logger;
+extern Metrics metrics;
+extern EphemerisCache ephemeris;
 
 void MainWindow::create_timers(void) {
     this->m_timer_display = new QTimer(this);
@@ -12,8 +22,69 @@ void MainWindow::create_timers(void) {
     this->connect(this->m_timer_long, &QTimer::timeout, this->ui->camera_allsky, &QCamera::update_clocks);
     this->connect(this->m_timer_long, &QTimer::timeout, this->ui->camera_spectral, &QCamera::update_clocks);
     this->m_timer_long->start();
+
+    this->m_timer_metrics = new QTimer(this);
+    this->m_timer_metrics->setInterval(MainWindow::MetricsInterval);
+    this->connect(this->m_timer_metrics, &QTimer::timeout, this, &MainWindow::write_metrics);
+    this->m_timer_metrics->start();
+
+    this->m_timer_ephemeris = new QTimer(this);
+    this->m_timer_ephemeris->setInterval(EphemerisCache::RefreshInterval);
+    this->connect(this->m_timer_ephemeris, &QTimer::timeout, this, &MainWindow::refresh_ephemeris);
+    this->m_timer_ephemeris->start();
+    this->refresh_ephemeris();
 }
 
 void MainWindow::process_display_timer(void) {
     this->display_time();
 }
+
+// Snapshot for a node exporter textfile collector or any other local scraper
+void MainWindow::write_metrics(void) {
+    // The ephemeris cache only counts, its counters are brought up to date here
+    static Metrics::Counter & hits = metrics.counter(Concern::Automatic, "ephemeris_queries{source=\"cache\"}");
+    static Metrics::Counter & misses = metrics.counter(Concern::Automatic, "ephemeris_queries{source=\"direct\"}");
+    hits.increment(ephemeris.hits() - hits.value());
+    misses.increment(ephemeris.misses() - misses.value());
+
+    metrics.write_text(MainWindow::MetricsFile);
+}
+
+// The fit takes a few hundred ephemeris evaluations, queries keep using the previous window meanwhile
+void MainWindow::refresh_ephemeris(void) {
+    if (!ephemeris.is_enabled()) {
+        return;
+    }
+
+    QThreadPool::globalInstance()->start([this]() {
+        const EphemerisCache::Summary summary = ephemeris.refresh();
+        QMetaObject::invokeMethod(this, [this, summary]() {
+            static Metrics::Gauge & sun_error = metrics.gauge(Concern::Automatic, "ephemeris_error_arcsec{body=\"sun\"}");
+            static Metrics::Gauge & moon_error = metrics.gauge(Concern::Automatic, "ephemeris_error_arcsec{body=\"moon\"}");
+            static Metrics::Gauge & segments = metrics.gauge(Concern::Automatic, "ephemeris_segments");
+            sun_error.set(summary.sun_error);
+            moon_error.set(summary.moon_error);
+            segments.set(summary.segments - summary.rejected);
+
+            if (summary.rejected > 0) {
+                logger.warning(Concern::Automatic, QString("Ephemeris cache: %1 of %2 segments exceed the error bound, computing them directly")
+                                                       .arg(summary.rejected).arg(summary.segments));
+            } else {
+                logger.debug(Concern::Automatic, QString("Ephemeris cache refitted until %1").arg(summary.to.toString(Qt::ISODate)));
+            }
+            this->ui->diagnostics->display("Ephemeris cache", summary.json());
+        }, Qt::QueuedConnection);
+    });
+}
+
+// The endpoint gets its own thread, so that a scrape never waits for the GUI and vice versa
+void MainWindow::create_metrics_server(void) {
+    this->m_metrics_thread = new QThread(this);
+    this->m_metrics_server = new QMetricsServer();
+    this->m_metrics_server->moveToThread(this->m_metrics_thread);
+    this->connect(this->m_metrics_thread, &QThread::finished, this->m_metrics_server, &QObject::deleteLater);
+    this->connect(this->m_metrics_server, &QMetricsServer::log, this, [](Concern concern, Level level, const QString & message) {
+        logger.write(level, concern, message);
+    }, Qt::QueuedConnection);
+    this->m_metrics_thread->start();
+}
@@ -0,0 +1,46 @@
+#include "models/qlogfilterproxy.h"
+
+
+QLogFilterProxy::QLogFilterProxy(QObject * parent):
+    QSortFilterProxyModel(parent),
+    m_level(Level::DebugDetail),
+    m_concern_mask(QLogFilterProxy::AllConcerns)
+{
+    // Re-filter rows as they are appended. No sort column is ever set, records stay in the order they arrived
+    this->setDynamicSortFilter(true);
+}
+
+bool QLogFilterProxy::filterAcceptsRow(int source_row, const QModelIndex & source_parent) const {
+    Q_UNUSED(source_parent);
+    const QLogModel * model = static_cast<const QLogModel *>(this->sourceModel());
+    const QLogModel::Entry & entry = model->entry(source_row);
+
+    if (static_cast<int>(entry.get_level()) > static_cast<int>(this->m_level)) {
+        return false;
+    }
+    if (!(this->m_concern_mask & (1u << entry.concern))) {
+        return false;
+    }
+    return this->m_search.isEmpty() || entry.message.contains(this->m_search, Qt::CaseInsensitive);
+}
+
+void QLogFilterProxy::set_level(Level level) {
+    if (level != this->m_level) {
+        this->m_level = level;
+        this->invalidateRowsFilter();
+    }
+}
+
+void QLogFilterProxy::set_concern_mask(quint32 mask) {
+    if (mask != this->m_concern_mask) {
+        this->m_concern_mask = mask;
+        this->invalidateRowsFilter();
+    }
+}
+
+void QLogFilterProxy::set_search(const QString & text) {
+    if (text != this->m_search) {
+        this->m_search = text;
+        this->invalidateRowsFilter();
+    }
+}
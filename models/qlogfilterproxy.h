@@ -0,0 +1,38 @@
+#ifndef QLOGFILTERPROXY_H
+#define QLOGFILTERPROXY_H
+
+#include <QSortFilterProxyModel>
+
+#include "models/qlogmodel.h"
+
+/**
+ * @brief The QLogFilterProxy class filters a QLogModel by the lowest severity shown,
+ *        a mask of concerns and a case-insensitive text search in the message.
+ *        The filter reads the compact entries directly, without going through `data`.
+ */
+class QLogFilterProxy: public QSortFilterProxyModel {
+    Q_OBJECT
+private:
+    Level m_level;
+    quint32 m_concern_mask;
+    QString m_search;
+
+protected:
+    bool filterAcceptsRow(int source_row, const QModelIndex & source_parent) const override;
+
+public:
+    constexpr static quint32 AllConcerns = 0xFFFFFFFF;
+
+    explicit QLogFilterProxy(QObject * parent = nullptr);
+
+    inline Level level(void) const { return this->m_level; }
+    inline quint32 concern_mask(void) const { return this->m_concern_mask; }
+    inline const QString & search(void) const { return this->m_search; }
+
+public slots:
+    void set_level(Level level);
+    void set_concern_mask(quint32 mask);
+    void set_search(const QString & text);
+};
+
+#endif // QLOGFILTERPROXY_H
@@ -0,0 +1,149 @@
+#include <QTimeZone>
+
+#include "models/qlogmodel.h"
+
+
+QLogModel::QLogModel(QObject * parent, int capacity):
+    QAbstractTableModel(parent),
+    m_capacity(qMax(1, capacity)),
+    m_head(0),
+    m_count(0)
+{}
+
+int QLogModel::rowCount(const QModelIndex & parent) const {
+    return parent.isValid() ? 0 : this->m_count;
+}
+
+int QLogModel::columnCount(const QModelIndex & parent) const {
+    return parent.isValid() ? 0 : 4;
+}
+
+QVariant QLogModel::data(const QModelIndex & index, int role) const {
+    if (!index.isValid() || (index.row() >= this->m_count)) {
+        return QVariant();
+    }
+
+    const Entry & entry = this->at(index.row());
+    switch (role) {
+        case Qt::DisplayRole: {
+            switch (index.column()) {
+                case Column::TimestampColumn:
+                    return QDateTime::fromMSecsSinceEpoch(entry.timestamp, QTimeZone::UTC).toString("yyyy-MM-dd hh:mm:ss.zzz");
+                case Column::LevelColumn:
+                    return EventLogger::Levels[entry.get_level()].name;
+                case Column::ConcernColumn:
+                    return EventLogger::Concerns[entry.get_concern()].full_name;
+                case Column::MessageColumn:
+                    return entry.message;
+                default:
+                    return QVariant();
+            }
+        }
+        case Qt::ForegroundRole: {
+            if (index.column() == Column::TimestampColumn) {
+                return QVariant();
+            }
+            return EventLogger::Levels[entry.get_level()].colour;
+        }
+        case Qt::TextAlignmentRole: {
+            if (index.column() == Column::MessageColumn) {
+                return QVariant(Qt::AlignLeft | Qt::AlignVCenter);
+            }
+            return Qt::AlignCenter;
+        }
+        default:
+            return QVariant();
+    }
+}
+
+QVariant QLogModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if ((role != Qt::DisplayRole) || (orientation != Qt::Horizontal)) {
+        return QVariant();
+    }
+
+    switch (section) {
+        case Column::TimestampColumn:   return "Timestamp";
+        case Column::LevelColumn:       return "Level";
+        case Column::ConcernColumn:     return "Concern";
+        case Column::MessageColumn:     return "Message";
+        default:                        return QVariant();
+    }
+}
+
+/**
+ * @brief QLogModel::set_capacity
+ * Changes the size of the ring, keeping as many of the newest entries as fit
+ */
+void QLogModel::set_capacity(int capacity) {
+    capacity = qMax(1, capacity);
+    if (capacity == this->m_capacity) {
+        return;
+    }
+
+    this->beginResetModel();
+    const int kept = qMin(this->m_count, capacity);
+    std::vector<Entry> ring;
+    ring.reserve(kept);
+    for (int row = this->m_count - kept; row < this->m_count; ++row) {
+        ring.push_back(std::move(this->m_ring[(this->m_head + row) % this->m_capacity]));
+    }
+    this->m_ring = std::move(ring);
+    this->m_capacity = capacity;
+    this->m_head = 0;
+    this->m_count = kept;
+    this->endResetModel();
+}
+
+void QLogModel::append(const LogRecord & record) {
+    this->append(QVector<LogRecord>{record});
+}
+
+/**
+ * @brief QLogModel::append
+ * Appends a batch of records. If the ring overflows, the oldest entries are evicted first,
+ * then the whole batch is inserted at the end with a single notification.
+ */
+void QLogModel::append(const QVector<LogRecord> & records) {
+    // Anything that would be evicted by the same batch is never shown at all
+    const int skip = qMax(0, static_cast<int>(records.count()) - this->m_capacity);
+    const int incoming = static_cast<int>(records.count()) - skip;
+    if (incoming == 0) {
+        return;
+    }
+
+    const int evicted = qMax(0, this->m_count + incoming - this->m_capacity);
+    if (evicted > 0) {
+        this->beginRemoveRows(QModelIndex(), 0, evicted - 1);
+        this->m_head = (this->m_head + evicted) % this->m_capacity;
+        this->m_count -= evicted;
+        this->endRemoveRows();
+    }
+
+    this->beginInsertRows(QModelIndex(), this->m_count, this->m_count + incoming - 1);
+    for (auto record = records.cbegin() + skip; record != records.cend(); ++record) {
+        Entry entry{
+            record->timestamp.toMSecsSinceEpoch(),
+            static_cast<quint8>(record->level),
+            static_cast<quint8>(record->concern),
+            record->message,
+        };
+
+        // The ring is filled lazily, so that an idle client does not reserve the full capacity
+        const std::size_t slot = (this->m_head + this->m_count) % this->m_capacity;
+        if (slot == this->m_ring.size()) {
+            this->m_ring.push_back(std::move(entry));
+        } else {
+            this->m_ring[slot] = std::move(entry);
+        }
+        this->m_count++;
+    }
+    this->endInsertRows();
+}
+
+void QLogModel::clear(void) {
+    this->beginResetModel();
+    this->m_ring.clear();
+    this->m_head = 0;
+    this->m_count = 0;
+    this->endResetModel();
+}
@@ -0,0 +1,66 @@
+#ifndef QLOGMODEL_H
+#define QLOGMODEL_H
+
+#include <vector>
+#include <QAbstractTableModel>
+#include <QVector>
+
+#include "logging/eventlogger.h"
+
+/**
+ * @brief The QLogModel class holds the most recent log records for display.
+ *        Records live in a fixed-capacity ring: appending is O(1) and, once the ring is full,
+ *        every new record evicts the oldest one. Records arrive in batches and each batch
+ *        is announced by a single rowsRemoved / rowsInserted pair, so the view does not relayout
+ *        for every line.
+ */
+class QLogModel: public QAbstractTableModel {
+    Q_OBJECT
+public:
+    constexpr static int DefaultCapacity = 100000;
+
+    typedef enum {
+        TimestampColumn = 0,
+        LevelColumn,
+        ConcernColumn,
+        MessageColumn,
+    } Column;
+
+    // Compact copy of a LogRecord, the timestamp is kept as ms since epoch (UTC)
+    struct Entry {
+        qint64 timestamp;
+        quint8 level;
+        quint8 concern;
+        QString message;
+
+        inline Level get_level(void) const { return static_cast<Level>(this->level); }
+        inline Concern get_concern(void) const { return static_cast<Concern>(this->concern); }
+    };
+
+private:
+    std::vector<Entry> m_ring;
+    int m_capacity;
+    int m_head;                 // Index of the oldest entry
+    int m_count;
+
+    inline const Entry & at(int row) const { return this->m_ring[(this->m_head + row) % this->m_capacity]; }
+
+public:
+    explicit QLogModel(QObject * parent = nullptr, int capacity = QLogModel::DefaultCapacity);
+
+    int rowCount(const QModelIndex & parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex & parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex & index, int role) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    inline int capacity(void) const { return this->m_capacity; }
+    void set_capacity(int capacity);
+
+    inline const Entry & entry(int row) const { return this->at(row); }
+
+    void append(const LogRecord & record);
+    void append(const QVector<LogRecord> & records);
+    void clear(void);
+};
+
+#endif // QLOGMODEL_H
@@ -1,12 +1,22 @@
+#include <algorithm>
+#include <random>
+#include <QRandomGenerator>
+
 #include "qsightingmodel.h"
 #include "widgets/qsightingbuffer.h"
 #include "logging/eventlogger.h"
+#include "utils/metrics.h"
 
 extern EventLogger logger;
+extern Metrics metrics;
 
 
 QSightingModel::QSightingModel(QObject * parent):
-    QAbstractTableModel(parent)
+    QAbstractTableModel(parent),
+    m_count_sent(0),
+    m_count_accepted(0),
+    m_count_rejected(0),
+    m_count_failed(0)
 {
     this->m_display_timer = new QTimer();
     this->m_display_timer->setInterval(QSightingModel::DeferRefreshInterval);
@@ -17,6 +27,9 @@ QSightingModel::QSightingModel(QObject * parent):
     this->m_send_timer->setInterval(QSightingModel::SendInterval);
     this->connect(this->m_send_timer, &QTimer::timeout, this, &QSightingModel::send_sightings);
     this->m_send_timer->start();
+
+    this->m_journal = new SightingJournal(this, "sightings.journal");
+    this->m_journal->initialize();
 }
 
 int QSightingModel::rowCount(const QModelIndex & index) const {
@@ -129,16 +142,109 @@ QVariant QSightingModel::headerData(int section, Qt::Orientation orientation, in
     }
 }
 
+/**
+ * @brief QSightingModel::send_sightings
+ * Upload scheduler: sends the oldest pending sightings that are not deferred,
+ * but never keeps more than MaxInFlight uploads waiting for a response
+ */
 void QSightingModel::send_sightings(void) {
+    static Metrics::Counter & sent = metrics.counter(Concern::Sightings, "sent");
+    static Metrics::Gauge & queued = metrics.gauge(Concern::Sightings, "queue_depth");
+    static Metrics::Gauge & in_flight = metrics.gauge(Concern::Sightings, "in_flight");
+    this->expire_in_flight();
+
+    QVector<Sighting *> queue;
     for (auto && sighting: this->sightings()) {
-        if ((!sighting.is_deferred()) && (!sighting.is_finished())) {
-            emit this->sighting_to_send(sighting);
-            sighting.defer(QSightingModel::DeferTime);
+        if (sighting.is_pending() && !sighting.is_deferred() && !this->m_in_flight.contains(sighting.prefix())) {
+            queue.append(&sighting);
+        }
+    }
+    std::sort(queue.begin(), queue.end(), [](const Sighting * first, const Sighting * second) {
+        return first->timestamp() < second->timestamp();
+    });
+
+    for (Sighting * sighting: queue) {
+        if (this->m_in_flight.count() >= QSightingModel::MaxInFlight) {
+            logger.debug(Concern::Sightings, QString("Upload limit reached, %1 sightings waiting").arg(this->queue_depth()));
+            break;
         }
+        this->m_in_flight.insert(sighting->prefix(), QDateTime::currentDateTimeUtc());
+        sighting->add_attempt();
+        this->m_count_sent++;
+        sent.increment();
+        emit this->sighting_to_send(*sighting);
     }
+    queued.set(this->queue_depth());
+    in_flight.set(this->in_flight());
     emit this->dataChanged(this->index(0, Property::Status), this->index(this->rowCount() - 1, Property::Status));
 }
 
+// Forget uploads that never received a response, so that they can be sent again
+void QSightingModel::expire_in_flight(void) {
+    static Metrics::Counter & expired = metrics.counter(Concern::Sightings, "expired");
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    for (auto item = this->m_in_flight.begin(); item != this->m_in_flight.end();) {
+        if (item.value().secsTo(now) > QSightingModel::InFlightTimeout) {
+            logger.warning(Concern::Sightings, QString("No response for sighting '%1', giving up waiting").arg(item.key()));
+            this->m_count_failed++;
+            expired.increment();
+            item = this->m_in_flight.erase(item);
+        } else {
+            ++item;
+        }
+    }
+}
+
+// An upload has finished (one way or another), make room for another one
+void QSightingModel::finish_upload(const QString & sighting_id) {
+    this->m_in_flight.remove(sighting_id);
+    QTimer::singleShot(0, this, &QSightingModel::send_sightings);
+}
+
+int QSightingModel::queue_depth(void) const {
+    int depth = 0;
+    for (auto && sighting: this->sightings()) {
+        if (sighting.is_pending() && !this->m_in_flight.contains(sighting.prefix())) {
+            depth++;
+        }
+    }
+    return depth;
+}
+
+// Accepted sightings per minute over the last ThroughputWindow seconds
+double QSightingModel::throughput(void) {
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    while (!this->m_accepted_times.isEmpty() && (this->m_accepted_times.head().secsTo(now) > QSightingModel::ThroughputWindow)) {
+        this->m_accepted_times.dequeue();
+    }
+    return this->m_accepted_times.count() * 60.0 / QSightingModel::ThroughputWindow;
+}
+
+double QSightingModel::base_defer_time(Sighting::Status status) {
+    switch (status) {
+        case Sighting::Status::RemoteHostClosed:    return 15;
+        case Sighting::Status::Timeout:             return 30;
+        case Sighting::Status::UnknownStation:      return 300;
+        default:                                    return QSightingModel::DeferTime;
+    }
+}
+
+/**
+ * @brief QSightingModel::backoff
+ * Exponential backoff depending on the kind of the last failure, with random jitter
+ * so that sightings deferred together are not all retried at the same moment.
+ * The exponent counts all upload attempts of the sighting, not only the consecutive failures
+ * of the last kind: a sighting that timed out once and then hits an unknown station starts
+ * from the doubled 300 s base. Failures of any kind are taken as a sign of trouble.
+ * @return time in seconds
+ */
+double QSightingModel::backoff(const Sighting & sighting) {
+    const unsigned int exponent = std::min(std::max(sighting.attempts(), 1u) - 1, 16u);
+    const double base = std::min(QSightingModel::base_defer_time(sighting.status()) * (1 << exponent), QSightingModel::MaxDeferTime);
+    std::uniform_real_distribution<double> jitter(-QSightingModel::BackoffJitter, QSightingModel::BackoffJitter);
+    return base * (1.0 + jitter(*QRandomGenerator::global()));
+}
+
 void QSightingModel::force_send_sightings(void) {
     for (auto && sighting: this->sightings()) {
         sighting.undefer();
@@ -155,8 +261,61 @@ void QSightingModel::insert_sighting(const Sighting & sighting) {
         logger.debug(Concern::Sightings, QString("Sighting '%1' already in model, ignoring").arg(sighting.prefix()));
     } else {
         logger.debug(Concern::Sightings, QString("Adding Sighting '%1").arg(sighting.prefix()));
+        static Metrics::Counter & scanned = metrics.counter(Concern::Sightings, "scanned");
+        scanned.increment();
         this->m_sightings.insert(sighting.prefix(), sighting);
         this->insertRow(this->rowCount());
+        this->resume(sighting.prefix());
+    }
+}
+
+/**
+ * @brief QSightingModel::resume
+ * Continues where a previous run left off with a sighting found in the journal:
+ * sightings already decided by the server are stored or discarded without sending them again,
+ * those that were sent but never answered are sent again, deferrals and attempts are kept.
+ */
+void QSightingModel::resume(const QString & sighting_id) {
+    Sighting & sighting = this->m_sightings[sighting_id];
+    const SightingJournal::Entry * entry = this->m_journal->find(sighting.uuid());
+    if (entry == nullptr) {
+        return;
+    }
+
+    sighting.restore(entry->status, entry->deferred_until, entry->attempts);
+
+    switch (entry->status) {
+        case Sighting::Status::Sent: {
+            this->set_status(sighting, Sighting::Status::Unprocessed);
+            break;
+        }
+        case Sighting::Status::Accepted:
+        case Sighting::Status::Stored: {
+            // Stored but found again means the files could not be moved, try again
+            logger.info(Concern::Sightings, QString("Sighting '%1' was already accepted, storing").arg(sighting_id));
+            this->set_status(sighting, Sighting::Status::Accepted);
+            QTimer::singleShot(0, this, [this, sighting_id]() {
+                Sighting * sighting = this->find(sighting_id);
+                if (sighting != nullptr) {
+                    emit this->sighting_accepted(*sighting);
+                }
+            });
+            break;
+        }
+        case Sighting::Status::Rejected:
+        case Sighting::Status::Discarded: {
+            logger.info(Concern::Sightings, QString("Sighting '%1' was already rejected, discarding").arg(sighting_id));
+            this->set_status(sighting, Sighting::Status::Rejected);
+            QTimer::singleShot(0, this, [this, sighting_id]() {
+                Sighting * sighting = this->find(sighting_id);
+                if (sighting != nullptr) {
+                    emit this->sighting_rejected(*sighting);
+                }
+            });
+            break;
+        }
+        default:
+            break;
     }
 }
 
@@ -179,60 +338,113 @@ bool QSightingModel::removeRows(int row, int count, const QModelIndex & index) {
 
 void QSightingModel::set_status(Sighting & sighting, Sighting::Status status) {
     sighting.set_status(status);
+    this->m_journal->record(sighting);
     emit this->dataChanged(this->index(0, Property::DeferredFor), this->index(this->rowCount() - 1, Property::Status));
 }
 
-void QSightingModel::mark_stored(Sighting & sighting) {
-    this->set_status(sighting, Sighting::Status::Stored);
+void QSightingModel::mark_stored(const QString & sighting_id) {
+    Sighting * sighting = this->find(sighting_id);
+    if (sighting != nullptr) {
+        sighting->undefer();
+        this->set_status(*sighting, Sighting::Status::Stored);
+    }
+}
+
+void QSightingModel::mark_discarded(const QString & sighting_id) {
+    Sighting * sighting = this->find(sighting_id);
+    if (sighting != nullptr) {
+        sighting->undefer();
+        this->set_status(*sighting, Sighting::Status::Discarded);
+    }
 }
 
-void QSightingModel::mark_discarded(Sighting & sighting) {
-    this->set_status(sighting, Sighting::Status::Discarded);
+Sighting * QSightingModel::find(const QString & sighting_id) {
+    auto item = this->m_sightings.find(sighting_id);
+    if (item == this->m_sightings.end()) {
+        logger.debug_error(Concern::Sightings, QString("Sighting '%1' is not in the model").arg(sighting_id));
+        return nullptr;
+    } else {
+        return &item.value();
+    }
 }
 
 void QSightingModel::mark_sent(const QString & sighting_id) {
-    auto & sighting = this->sightings()[sighting_id];
-    this->set_status(sighting, Sighting::Status::Sent);
+    Sighting * sighting = this->find(sighting_id);
+    if (sighting != nullptr) {
+        this->set_status(*sighting, Sighting::Status::Sent);
+    }
 }
 
 void QSightingModel::store_sighting(const QString & sighting_id) {
-    auto & sighting = this->sightings()[sighting_id];
-    this->set_status(sighting, Sighting::Status::Accepted);
-    emit this->sighting_accepted(sighting);
+    static Metrics::Counter & accepted = metrics.counter(Concern::Sightings, "accepted");
+    this->finish_upload(sighting_id);
+    this->m_count_accepted++;
+    accepted.increment();
+    this->m_accepted_times.enqueue(QDateTime::currentDateTimeUtc());
+
+    Sighting * sighting = this->find(sighting_id);
+    if (sighting != nullptr) {
+        this->set_status(*sighting, Sighting::Status::Accepted);
+        emit this->sighting_accepted(*sighting);
+    }
 }
 
 void QSightingModel::discard_sighting(const QString & sighting_id) {
-    auto & sighting = this->sightings()[sighting_id];
-    this->set_status(sighting, Sighting::Status::Rejected);
-    emit this->sighting_rejected(sighting);
+    static Metrics::Counter & rejected = metrics.counter(Concern::Sightings, "rejected");
+    this->finish_upload(sighting_id);
+    this->m_count_rejected++;
+    rejected.increment();
+
+    Sighting * sighting = this->find(sighting_id);
+    if (sighting != nullptr) {
+        this->set_status(*sighting, Sighting::Status::Rejected);
+        emit this->sighting_rejected(*sighting);
+    }
 }
 
 void QSightingModel::defer_sighting(const QString & sighting_id, QNetworkReply::NetworkError error) {
-    auto & sighting = this->sightings()[sighting_id];
+    static Metrics::Counter & deferred = metrics.counter(Concern::Sightings, "deferred");
+    this->finish_upload(sighting_id);
+    this->m_count_failed++;
+    deferred.increment();
+
+    Sighting * sighting = this->find(sighting_id);
+    if (sighting == nullptr) {
+        return;
+    }
+
+    Sighting::Status status;
     switch (error) {
         case QNetworkReply::UnknownContentError: {
-            this->set_status(sighting, Sighting::Status::UnknownStation);
+            status = Sighting::Status::UnknownStation;
             break;
         }
         case QNetworkReply::RemoteHostClosedError: {
-            this->set_status(sighting, Sighting::Status::RemoteHostClosed);
+            status = Sighting::Status::RemoteHostClosed;
             break;
         }
         case QNetworkReply::TimeoutError: {
-            this->set_status(sighting, Sighting::Status::Timeout);
+            status = Sighting::Status::Timeout;
             break;
         }
         default: {
-            this->set_status(sighting, Sighting::Status::UnknownError);
+            status = Sighting::Status::UnknownError;
             break;
         }
     }
-    sighting.defer(QSightingModel::DeferTime);
-    emit this->sighting_deferred(sighting);
+
+    // The backoff depends on the new status, the journal gets a single record with both
+    sighting->set_status(status);
+    sighting->defer(QSightingModel::backoff(*sighting));
+    this->m_journal->record(*sighting);
+    emit this->dataChanged(this->index(0, Property::DeferredFor), this->index(this->rowCount() - 1, Property::Status));
+    emit this->sighting_deferred(*sighting);
 }
 
 void QSightingModel::clear(void) {
     this->m_sightings.clear();
+    this->m_in_flight.clear();
     this->beginResetModel();
     this->endResetModel();
+    emit this->cleared();
 }
@@ -5,8 +5,10 @@
 #include <QObject>
 #include <QNetworkReply>
 #include <QTimer>
+#include <QQueue>
 
 #include "utils/sighting.h"
+#include "utils/sightingjournal.h"
 
 QT_FORWARD_DECLARE_CLASS(QSightingBuffer);
 
@@ -17,6 +19,12 @@ private:
     constexpr static int DeferRefreshInterval = 100;        // Time in ms: how often to refresh the view
     constexpr static int SendInterval = 5000;               // Time in ms: how often to try to send sightings
 
+    constexpr static int MaxInFlight = 4;                   // Maximum number of uploads waiting for a response
+    constexpr static int InFlightTimeout = 300;             // Time in seconds: stop waiting for a response after this
+    constexpr static double MaxDeferTime = 3600;            // Time in seconds: upper limit of the exponential backoff
+    constexpr static double BackoffJitter = 0.2;            // Relative random spread of the backoff
+    constexpr static int ThroughputWindow = 600;            // Time in seconds: window for computing the throughput
+
     typedef enum {
         ID = 0,
         Spectral,
@@ -28,9 +36,27 @@ private:
 
     QMap<QString, Sighting> m_sightings;
 
+    // Upload scheduler: sightings waiting for a response and the time they were sent
+    QHash<QString, QDateTime> m_in_flight;
+    QQueue<QDateTime> m_accepted_times;
+    quint64 m_count_sent;
+    quint64 m_count_accepted;
+    quint64 m_count_rejected;
+    quint64 m_count_failed;
+
     QTimer * m_display_timer;
     QTimer * m_send_timer;
 
+    // Status transitions survive restarts, so that sightings are not sent again
+    SightingJournal * m_journal;
+    void resume(const QString & sighting_id);
+
+    Sighting * find(const QString & sighting_id);
+    void finish_upload(const QString & sighting_id);
+    void expire_in_flight(void);
+    static double base_defer_time(Sighting::Status status);
+    static double backoff(const Sighting & sighting);
+
     virtual bool insertRows(int row, int count, const QModelIndex & parent = QModelIndex()) override;
     virtual bool removeRows(int row, int count, const QModelIndex & parent = QModelIndex()) override;
 public:
@@ -43,6 +69,15 @@ public:
 
     inline QMap<QString, Sighting> & sightings(void) { return this->m_sightings; }
     inline const QMap<QString, Sighting> & sightings(void) const { return this->m_sightings; }
+
+    // Upload scheduler counters
+    inline int in_flight(void) const { return this->m_in_flight.count(); }
+    int queue_depth(void) const;
+    double throughput(void);
+    inline quint64 count_sent(void) const { return this->m_count_sent; }
+    inline quint64 count_accepted(void) const { return this->m_count_accepted; }
+    inline quint64 count_rejected(void) const { return this->m_count_rejected; }
+    inline quint64 count_failed(void) const { return this->m_count_failed; }
 private slots:
     void update_timers(void);
     void set_status(Sighting & sighting, Sighting::Status status);
@@ -50,8 +85,8 @@ public slots:
     void send_sightings(void);
     void force_send_sightings(void);
     void insert_sighting(const Sighting & sighting);        // found by camera
-    void mark_stored(Sighting & sighting);                  // stored by camera
-    void mark_discarded(Sighting & sighting);               // discarded by camera
+    void mark_stored(const QString & sighting_id);          // stored by camera
+    void mark_discarded(const QString & sighting_id);       // discarded by camera
 
     void mark_sent(const QString & sighting_id);            // sent by server, but no response so far
     void store_sighting(const QString & sighting_id);       // accepted by server
@@ -66,6 +101,7 @@ signals:
     void sighting_accepted(Sighting & sighting);
     void sighting_rejected(Sighting & sighting);
     void sighting_deferred(Sighting & sighting);
+    void cleared(void);
 };
 
 #endif // QSIGHTINGMODEL_H
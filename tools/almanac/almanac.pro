@@ -0,0 +1,26 @@
+QT      = core
+CONFIG += c++20 console
+CONFIG -= app_bundle
+
+# Darkness windows for a whole network of stations, read from their settings.ini files
+TARGET = almanac
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp \
+    ../../APC/APC_Cheb.cpp \
+    ../../APC/APC_Math.cpp \
+    ../../APC/APC_Moon.cpp \
+    ../../APC/APC_PrecNut.cpp \
+    ../../APC/APC_Spheric.cpp \
+    ../../APC/APC_Sun.cpp \
+    ../../APC/APC_Time.cpp \
+    ../../APC/APC_VecMat3D.cpp \
+    ../../utils/almanac.cpp \
+    ../../utils/ephemeriscache.cpp \
+    ../../utils/universe.cpp
+
+HEADERS += \
+    ../../utils/almanac.h \
+    ../../utils/ephemeriscache.h \
+    ../../utils/universe.h
@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSettings>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QVector>
+
+#include "utils/almanac.h"
+#include "utils/ephemeriscache.h"
+
+// Required by Universe; the date range is usually far from now, so the cache stays disabled
+EphemerisCache ephemeris;
+
+namespace {
+    constexpr double DefaultDarknessLimit = -12.0;  // Angle in degrees, the same as QCamera
+
+    struct Schedule {
+        QString station;
+        QString camera;
+        double altitude;
+        Almanac almanac;
+        QVector<Almanac::Night> nights;
+    };
+
+    QTextStream err(stderr);
+
+    // Settings files, directories are searched recursively for settings.ini
+    QStringList find_settings(const QStringList & paths) {
+        QStringList files;
+        for (const QString & path: paths) {
+            if (QFileInfo(path).isDir()) {
+                QDirIterator iterator(path, {"settings.ini"}, QDir::Files, QDirIterator::Subdirectories);
+                while (iterator.hasNext()) {
+                    files.append(iterator.next());
+                }
+            } else {
+                files.append(path);
+            }
+        }
+        files.sort();
+        return files;
+    }
+
+    /**
+     * One schedule per enabled camera of the station, or a single one for `limit` if `custom` is set.
+     * Stations without coordinates are skipped rather than computed for the client's defaults.
+     */
+    QVector<Schedule> load_station(const QString & path, bool custom, double limit) {
+        QSettings settings(path, QSettings::IniFormat);
+        if (settings.status() != QSettings::NoError) {
+            err << "Could not read " << path << Qt::endl;
+            return {};
+        }
+
+        bool ok_latitude, ok_longitude;
+        const double latitude = settings.value("station/latitude").toDouble(&ok_latitude);
+        const double longitude = settings.value("station/longitude").toDouble(&ok_longitude);
+        if (!ok_latitude || !ok_longitude) {
+            err << "No station position in " << path << ", skipped" << Qt::endl;
+            return {};
+        }
+        const QString station = settings.value("station/id", QFileInfo(path).dir().dirName()).toString();
+        const double altitude = settings.value("station/altitude", 0.0).toDouble();
+
+        if (custom) {
+            return {Schedule{station, "custom", altitude, Almanac(latitude, longitude, limit), {}}};
+        }
+
+        QVector<Schedule> schedules;
+        for (const QString & camera: QStringList {"allsky", "spectral"}) {
+            if (settings.value(QString("camera_%1/enabled").arg(camera), true).toBool()) {
+                const double darkness = settings.value(QString("camera_%1/darkness_limit").arg(camera), DefaultDarknessLimit).toDouble();
+                schedules.append(Schedule{station, camera, altitude, Almanac(latitude, longitude, darkness), {}});
+            }
+        }
+        return schedules;
+    }
+
+    QDate parse_date(const QString & text, const QDate & fallback) {
+        return text.isEmpty() ? fallback : QDate::fromString(text, Qt::ISODate);
+    }
+}
+
+int main(int argc, char * argv[]) {
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("almanac");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Computes nightly darkness windows for AMOS stations from their settings.ini files.\n"
+                                     "Dates are ISO 8601, a night is named by the date of its evening. Times are UTC.");
+    parser.addHelpOption();
+    parser.addOption({{"f", "from"}, "First night, today by default.", "date"});
+    parser.addOption({{"t", "to"}, "Last night, a year after the first one by default.", "date"});
+    parser.addOption({{"d", "darkness-limit"}, "Use this solar altitude instead of the darkness limits of the cameras.", "degrees"});
+    parser.addOption({"format", "Output format, csv (default) or json.", "format", "csv"});
+    parser.addOption({{"j", "threads"}, "Number of threads, all cores by default.", "count"});
+    parser.addOption({{"o", "output"}, "Write to <file> instead of the standard output.", "file"});
+    parser.addPositionalArgument("paths", "Settings files or directories containing them.", "paths...");
+    parser.process(app);
+
+    const QDate from = parse_date(parser.value("from"), QDate::currentDate());
+    const QDate to = parse_date(parser.value("to"), from.addYears(1).addDays(-1));
+    if (!from.isValid() || !to.isValid() || (from > to)) {
+        err << "Invalid date range" << Qt::endl;
+        return 2;
+    }
+    const int days = static_cast<int>(from.daysTo(to)) + 1;
+
+    bool ok = true;
+    const bool custom = parser.isSet("darkness-limit");
+    const double limit = custom ? parser.value("darkness-limit").toDouble(&ok) : DefaultDarknessLimit;
+    const QString format = parser.value("format");
+    if (!ok || ((format != "csv") && (format != "json"))) {
+        parser.showHelp(2);
+    }
+
+    const QStringList files = find_settings(parser.positionalArguments());
+    if (files.isEmpty()) {
+        parser.showHelp(1);
+    }
+
+    QVector<Schedule> schedules;
+    for (const QString & file: files) {
+        schedules.append(load_station(file, custom, limit));
+    }
+    if (schedules.isEmpty()) {
+        err << "No station to compute" << Qt::endl;
+        return 1;
+    }
+
+    ephemeris.configure(false, EphemerisCache::DefaultMaxError);
+
+    // Every (schedule, batch of nights) is a task of its own, so that a few stations still use all cores
+    QThreadPool pool;
+    if (parser.isSet("threads")) {
+        pool.setMaxThreadCount(std::max(1, parser.value("threads").toInt()));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (Schedule & schedule: schedules) {
+        schedule.nights.resize(days);
+        Almanac::Night * nights = schedule.nights.data();
+        const Almanac * almanac = &schedule.almanac;
+        for (int batch = 0; batch < days; batch += Almanac::NightsPerTask) {
+            pool.start([almanac, nights, from, batch, days]() {
+                for (int i = batch; i < std::min(days, batch + Almanac::NightsPerTask); ++i) {
+                    nights[i] = almanac->night(from.addDays(i));
+                }
+            });
+        }
+    }
+    pool.waitForDone();
+    err << schedules.count() << " schedules of " << days << " nights computed in " << timer.elapsed() << " ms using "
+        << pool.maxThreadCount() << " threads" << Qt::endl;
+
+    QFile output;
+    if (parser.isSet("output")) {
+        output.setFileName(parser.value("output"));
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            err << "Could not open " << output.fileName() << ": " << output.errorString() << Qt::endl;
+            return 1;
+        }
+    } else {
+        output.open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+    }
+
+    QTextStream out(&output);
+    if (format == "json") {
+        QJsonArray array;
+        for (const Schedule & schedule: schedules) {
+            QJsonObject object = schedule.almanac.json(schedule.nights);
+            object["station"] = schedule.station;
+            object["camera"] = schedule.camera;
+            object["altitude"] = schedule.altitude;
+            array.append(object);
+        }
+        out << QJsonDocument(array).toJson();
+    } else {
+        out << "station,camera,darkness_limit," << Almanac::CsvHeader << '\n';
+        for (const Schedule & schedule: schedules) {
+            const QString prefix = QString("%1,%2,%3,").arg(schedule.station, schedule.camera)
+                                                       .arg(schedule.almanac.darkness_limit());
+            for (const Almanac::Night & night: schedule.nights) {
+                out << prefix << Almanac::csv(night) << '\n';
+            }
+        }
+    }
+    out.flush();
+
+    return 0;
+}
@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <limits>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QTimeZone>
+#include <QVector>
+
+#include "logging/staterecord.h"
+
+namespace {
+    constexpr qint64 ChunkRecords = 4096;           // Number of records read at once
+
+    struct IndexEntry {
+        qint64 timestamp;
+        qint64 record;
+    };
+
+    QTextStream err(stderr);
+
+    // Read the sidecar index; if it is missing, build one by reading every IndexStride-th timestamp
+    QVector<IndexEntry> load_index(QFile & file, const QString & index_path, qint64 records) {
+        QVector<IndexEntry> index;
+
+        QFile sidecar(index_path);
+        if (sidecar.open(QIODevice::ReadOnly)) {
+            const QByteArray data = sidecar.readAll();
+            for (qsizetype offset = 0; offset + StateRecord::IndexEntrySize <= data.size(); offset += StateRecord::IndexEntrySize) {
+                const IndexEntry entry{
+                    qFromLittleEndian<qint64>(data.constData() + offset),
+                    qFromLittleEndian<qint64>(data.constData() + offset + 8),
+                };
+                if (entry.record < records) {
+                    index.append(entry);
+                }
+            }
+            if (!index.isEmpty()) {
+                return index;
+            }
+        }
+
+        char buffer[sizeof(qint64)];
+        for (qint64 record = 0; record < records; record += StateRecord::IndexStride) {
+            if (!file.seek(StateRecord::HeaderSize + record * StateRecord::RecordSize) ||
+                (file.read(buffer, sizeof(buffer)) != sizeof(buffer))) {
+                break;
+            }
+            index.append(IndexEntry{StateRecord::decode_timestamp(buffer), record});
+        }
+        return index;
+    }
+
+    void write_csv_header(QTextStream & out) {
+        out << "timestamp,sun_altitude,state,valid_s,valid_t,valid_z,basic,env,errors,time_alive,"
+               "temperature_sht,temperature_lens,temperature_cpu,humidity,shaft_position\n";
+    }
+
+    void write_csv(QTextStream & out, const StateRecord & record) {
+        out << QDateTime::fromMSecsSinceEpoch(record.timestamp, QTimeZone::UTC).toString(Qt::ISODateWithMs) << ','
+            << StateRecord::undeci(record.sun_altitude) << ','
+            << record.state << ','
+            << ((record.valid & StateRecord::ValidS) ? 1 : 0) << ','
+            << ((record.valid & StateRecord::ValidT) ? 1 : 0) << ','
+            << ((record.valid & StateRecord::ValidZ) ? 1 : 0) << ','
+            << static_cast<int>(record.basic) << ','
+            << static_cast<int>(record.env) << ','
+            << static_cast<int>(record.errors) << ','
+            << record.time_alive << ','
+            << StateRecord::undeci(record.temperature_sht) << ','
+            << StateRecord::undeci(record.temperature_lens) << ','
+            << StateRecord::undeci(record.temperature_cpu) << ','
+            << StateRecord::undeci(record.humidity) << ','
+            << record.shaft_position << '\n';
+    }
+
+    /**
+     * Writes all records of one file within [from, to] as CSV. The index locates the last
+     * indexed record before `from`, from there the file is read sequentially in chunks
+     * until a record is past `to`.
+     * @return number of records written, or -1 if the file could not be read
+     */
+    qint64 scan(const QString & path, qint64 from, qint64 to, QTextStream & out) {
+        QFile file(path);
+        char header[StateRecord::HeaderSize];
+        if (!file.open(QIODevice::ReadOnly) ||
+            (file.read(header, StateRecord::HeaderSize) != StateRecord::HeaderSize) ||
+            !StateRecord::check_header(header)) {
+            err << "Not a state log: " << path << Qt::endl;
+            return -1;
+        }
+
+        const qint64 records = (file.size() - StateRecord::HeaderSize) / StateRecord::RecordSize;
+        const QFileInfo info(path);
+        const QVector<IndexEntry> index = load_index(file, info.dir().filePath(info.completeBaseName() + ".idx"), records);
+
+        auto entry = std::lower_bound(index.cbegin(), index.cend(), from,
+                                      [](const IndexEntry & e, qint64 timestamp) { return e.timestamp < timestamp; });
+        const qint64 start = (entry == index.cbegin()) ? 0 : std::prev(entry)->record;
+
+        QByteArray chunk(ChunkRecords * StateRecord::RecordSize, Qt::Uninitialized);
+        qint64 written = 0;
+        file.seek(StateRecord::HeaderSize + start * StateRecord::RecordSize);
+        for (;;) {
+            const qint64 read = file.read(chunk.data(), chunk.size()) / StateRecord::RecordSize;
+            if (read <= 0) {
+                return written;
+            }
+            for (qint64 i = 0; i < read; ++i) {
+                const char * buffer = chunk.constData() + i * StateRecord::RecordSize;
+                const qint64 timestamp = StateRecord::decode_timestamp(buffer);
+                if (timestamp > to) {
+                    return written;
+                }
+                if (timestamp >= from) {
+                    write_csv(out, StateRecord::decode(buffer));
+                    written++;
+                }
+            }
+        }
+    }
+
+    qint64 parse_time(const QString & text, qint64 fallback) {
+        if (text.isEmpty()) {
+            return fallback;
+        }
+        QDateTime time = QDateTime::fromString(text, Qt::ISODateWithMs);
+        if (!time.isValid()) {
+            time = QDateTime(QDate::fromString(text, Qt::ISODate), QTime(0, 0), QTimeZone::UTC);
+        }
+        if (time.timeSpec() == Qt::LocalTime) {
+            time.setTimeZone(QTimeZone::UTC);
+        }
+        return time.isValid() ? time.toMSecsSinceEpoch() : fallback;
+    }
+}
+
+int main(int argc, char * argv[]) {
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("statelog");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Exports the binary AMOS state log as CSV.\n"
+                                     "Times are ISO 8601, UTC unless stated otherwise, e.g. 2024-01-31T18:00:00.");
+    parser.addHelpOption();
+    parser.addOption({{"f", "from"}, "Only records at or after <time>.", "time"});
+    parser.addOption({{"t", "to"}, "Only records at or before <time>.", "time"});
+    parser.addOption({{"o", "output"}, "Write CSV to <file> instead of the standard output.", "file"});
+    parser.addPositionalArgument("paths", "State log files (.bin) or directories containing them.", "paths...");
+    parser.process(app);
+
+    const qint64 from = parse_time(parser.value("from"), std::numeric_limits<qint64>::min());
+    const qint64 to = parse_time(parser.value("to"), std::numeric_limits<qint64>::max());
+    if (from > to) {
+        err << "The start of the range is after its end" << Qt::endl;
+        return 2;
+    }
+
+    // Monthly files sort chronologically by name
+    QStringList files;
+    for (const QString & path: parser.positionalArguments()) {
+        const QFileInfo info(path);
+        if (info.isDir()) {
+            for (const QFileInfo & file: QDir(path).entryInfoList({"*.bin"}, QDir::Files, QDir::Name)) {
+                files.append(file.filePath());
+            }
+        } else {
+            files.append(path);
+        }
+    }
+    if (files.isEmpty()) {
+        parser.showHelp(1);
+    }
+    std::sort(files.begin(), files.end(), [](const QString & left, const QString & right) {
+        return QFileInfo(left).fileName() < QFileInfo(right).fileName();
+    });
+
+    QFile output;
+    if (parser.isSet("output")) {
+        output.setFileName(parser.value("output"));
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            err << "Could not open " << output.fileName() << ": " << output.errorString() << Qt::endl;
+            return 1;
+        }
+    } else {
+        output.open(stdout, QIODevice::WriteOnly | QIODevice::Text);
+    }
+
+    QTextStream out(&output);
+    write_csv_header(out);
+
+    int status = 0;
+    qint64 total = 0;
+    for (const QString & file: files) {
+        const qint64 written = scan(file, from, to, out);
+        if (written < 0) {
+            status = 1;
+        } else {
+            total += written;
+        }
+    }
+    out.flush();
+
+    err << total << " records exported" << Qt::endl;
+    return status;
+}
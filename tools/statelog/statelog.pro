@@ -0,0 +1,13 @@
+QT      = core
+CONFIG += c++20 console
+CONFIG -= app_bundle
+
+# Reader for the binary state log written by the client (logs/state-YYYYMM.bin)
+TARGET = statelog
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp
+
+HEADERS += \
+    ../../logging/staterecord.h
@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QTimeZone>
+#include <QVector>
+
+#include "utils/ephemeriscache.h"
+#include "utils/universe.h"
+
+// Required by Universe, enabled only with --cache
+EphemerisCache ephemeris;
+
+namespace {
+    constexpr double DefaultLatitude = 48.0;        // Angle in degrees, the same as QStation
+    constexpr double DefaultLongitude = 17.0;       // Angle in degrees, the same as QStation
+    constexpr double Tolerance = 1e-6;              // Angle in degrees: largest difference accepted between the paths
+
+    typedef Polar (*PositionFunction)(const double latitude, const double longitude, const QDateTime & time);
+    typedef Universe::HorizonTrack (*TrackFunction)(double latitude, double longitude, double start, double step, qsizetype count);
+
+    struct Result {
+        double scalar_ms = std::numeric_limits<double>::infinity();
+        double track_ms = std::numeric_limits<double>::infinity();
+        double altitude_error = 0;
+        double azimuth_error = 0;
+    };
+
+    QTextStream out(stdout);
+
+    // Difference of two azimuths in degrees, across the north as well
+    double azimuth_difference(double first, double second) {
+        const double difference = std::fabs(first - second);
+        return std::min(difference, 360.0 - difference);
+    }
+
+    /**
+     * Times `count` instants from `start` in steps of `step` ms, once through the scalar function for every instant
+     * and once through the track, and compares the results. The best of `repeat` runs is kept for each path.
+     */
+    Result run(PositionFunction position, TrackFunction track, double latitude, double longitude,
+               const QDateTime & start, qint64 step, qsizetype count, int repeat) {
+        Result result;
+        QVector<double> altitude(count), azimuth(count);
+        Universe::HorizonTrack batch;
+        QElapsedTimer timer;
+
+        for (int r = 0; r < repeat; ++r) {
+            timer.start();
+            for (qsizetype i = 0; i < count; ++i) {
+                const Polar polar = position(latitude, longitude, start.addMSecs(i * step));
+                altitude[i] = polar.theta * Deg;
+                azimuth[i] = std::fmod(polar.phi * Deg + 360.0, 360.0);
+            }
+            result.scalar_ms = std::min(result.scalar_ms, timer.nsecsElapsed() / 1e6);
+
+            timer.start();
+            batch = track(latitude, longitude, Universe::mjd(start), step / 86400000.0, count);
+            result.track_ms = std::min(result.track_ms, timer.nsecsElapsed() / 1e6);
+        }
+
+        for (qsizetype i = 0; i < count; ++i) {
+            result.altitude_error = std::max(result.altitude_error, std::fabs(altitude[i] - batch.altitude[i]));
+            result.azimuth_error = std::max(result.azimuth_error, azimuth_difference(azimuth[i], batch.azimuth[i]));
+        }
+        return result;
+    }
+
+    bool report(const QString & body, const Result & result) {
+        const bool ok = (result.altitude_error <= Tolerance) && (result.azimuth_error <= Tolerance);
+        out << QString("%1  %2 ms  %3 ms  %4x  %5°  %6°  %7")
+                   .arg(body, -5)
+                   .arg(result.scalar_ms, 10, 'f', 2)
+                   .arg(result.track_ms, 8, 'f', 2)
+                   .arg(result.scalar_ms / result.track_ms, 6, 'f', 2)
+                   .arg(result.altitude_error, 9, 'e', 2)
+                   .arg(result.azimuth_error, 9, 'e', 2)
+                   .arg(ok ? "ok" : "MISMATCH") << Qt::endl;
+        return ok;
+    }
+}
+
+int main(int argc, char * argv[]) {
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("trackbench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compares Universe::sun_track and moon_track with sun_position and moon_position\n"
+                                     "called for every instant: the time taken by each path and the largest differences.\n"
+                                     "Exits with 1 if the paths differ by more than 1e-6°.");
+    parser.addHelpOption();
+    parser.addOption({"start", "First instant in ISO 8601, UTC, now by default.", "time"});
+    parser.addOption({"days", "Length of the sampled interval, 7 days by default.", "days", "7"});
+    parser.addOption({"step", "Time between instants, 10 s by default.", "seconds", "10"});
+    parser.addOption({"repeat", "Number of runs, the best one is reported, 5 by default.", "count", "5"});
+    parser.addOption({"latitude", "Latitude of the station, 48° by default.", "degrees", QString::number(DefaultLatitude)});
+    parser.addOption({"longitude", "Longitude of the station, 17° by default.", "degrees", QString::number(DefaultLongitude)});
+    parser.addOption({"cache", "Query the ephemeris cache instead of MiniSun and MiniMoon. It is refreshed at the start "
+                                "and covers the following 42 hours, later instants fall back to the direct computation."});
+    parser.process(app);
+
+    QDateTime start = QDateTime::currentDateTimeUtc();
+    start.setTime(QTime(start.time().hour(), start.time().minute(), start.time().second()));
+    if (parser.isSet("start")) {
+        start = QDateTime::fromString(parser.value("start"), Qt::ISODate);
+        if (start.timeSpec() == Qt::LocalTime) {
+            start.setTimeZone(QTimeZone::UTC);
+        }
+    }
+
+    bool ok_days, ok_step, ok_repeat, ok_latitude, ok_longitude;
+    const double days = parser.value("days").toDouble(&ok_days);
+    const qint64 step = std::llround(parser.value("step").toDouble(&ok_step) * 1000);
+    const int repeat = parser.value("repeat").toInt(&ok_repeat);
+    const double latitude = parser.value("latitude").toDouble(&ok_latitude);
+    const double longitude = parser.value("longitude").toDouble(&ok_longitude);
+    if (!start.isValid() || !ok_days || !ok_step || !ok_repeat || !ok_latitude || !ok_longitude ||
+        (days <= 0) || (step <= 0) || (repeat <= 0)) {
+        parser.showHelp(2);
+    }
+    const qsizetype count = static_cast<qsizetype>(days * 86400000.0 / step);
+
+    ephemeris.configure(parser.isSet("cache"), EphemerisCache::DefaultMaxError);
+    if (parser.isSet("cache")) {
+        ephemeris.refresh(start);
+    }
+
+    out << QString("%1 instants from %2, every %3 s, %4, best of %5 runs")
+               .arg(count).arg(start.toString(Qt::ISODate)).arg(step / 1000.0)
+               .arg(parser.isSet("cache") ? "ephemeris cache" : "direct computation").arg(repeat) << Qt::endl;
+    out << "body      scalar     track  speedup  altitude   azimuth" << Qt::endl;
+
+    bool ok = true;
+    ok &= report("Sun", run(Universe::sun_position, Universe::sun_track, latitude, longitude, start, step, count, repeat));
+    ok &= report("Moon", run(Universe::moon_position, Universe::moon_track, latitude, longitude, start, step, count, repeat));
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,24 @@
+QT      = core
+CONFIG += c++20 console
+CONFIG -= app_bundle
+
+# Benchmark of the batch horizon coordinates (Universe::sun_track, moon_track) against the scalar path
+TARGET = trackbench
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp \
+    ../../APC/APC_Cheb.cpp \
+    ../../APC/APC_Math.cpp \
+    ../../APC/APC_Moon.cpp \
+    ../../APC/APC_PrecNut.cpp \
+    ../../APC/APC_Spheric.cpp \
+    ../../APC/APC_Sun.cpp \
+    ../../APC/APC_Time.cpp \
+    ../../APC/APC_VecMat3D.cpp \
+    ../../utils/ephemeriscache.cpp \
+    ../../utils/universe.cpp
+
+HEADERS += \
+    ../../utils/ephemeriscache.h \
+    ../../utils/universe.h
@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <QThreadPool>
+#include <QTimeZone>
+#include <QJsonArray>
+
+#include "utils/almanac.h"
+#include "utils/universe.h"
+
+
+Almanac::Almanac(double latitude, double longitude, double darkness_limit):
+    m_latitude(latitude),
+    m_longitude(longitude),
+    m_darkness_limit(darkness_limit)
+{}
+
+Almanac::Night Almanac::night(const QDate & date) const {
+    Night night;
+    night.date = date;
+
+    const QDateTime noon = QDateTime(date, QTime(12, 0), QTimeZone::UTC).addSecs(std::llround(-this->m_longitude * 240.0));
+    const QDateTime next_noon = noon.addDays(1);
+    const double start = Universe::mjd(noon);
+    const double end = Universe::mjd(next_noon);
+
+    // Dark intervals, in MJD, from the exact crossings of the darkness limit
+    QVector<std::pair<double, double>> dark;
+    double since = (Universe::sun_altitude(this->m_latitude, this->m_longitude, noon) < this->m_darkness_limit) ? start : -1;
+    for (const Universe::Crossing & crossing: Universe::crossings(Universe::sun_altitude, this->m_latitude, this->m_longitude,
+                                                                  this->m_darkness_limit, noon, next_noon)) {
+        if (crossing.direction_up) {
+            if (since >= 0) {
+                dark.append({since, Universe::mjd(crossing.time)});
+            }
+            night.dawn = crossing.time;
+            since = -1;
+        } else {
+            if (!night.dusk.isValid()) {
+                night.dusk = crossing.time;
+            }
+            since = Universe::mjd(crossing.time);
+        }
+    }
+    if (since >= 0) {
+        dark.append({since, end});
+    }
+
+    std::pair<double, double> longest = {start + 0.5, start + 0.5};
+    for (const auto & [from, to]: dark) {
+        night.dark_hours += (to - from) * 24.0;
+        if (to - from > longest.second - longest.first) {
+            longest = {from, to};
+        }
+    }
+
+    // The Moon only matters while it is dark, every sample stands for a step around it
+    const double step = Almanac::MoonStep / 86400.0;
+    const qsizetype count = static_cast<qsizetype>(std::ceil((end - start) / step));
+    const Universe::HorizonTrack moon = Universe::moon_track(this->m_latitude, this->m_longitude, start + step / 2, step, count);
+    for (qsizetype i = 0; i < count; ++i) {
+        if (moon.altitude[i] >= Almanac::MoonHorizon) {
+            continue;
+        }
+        const double from = start + i * step;
+        const double to = std::min(end, from + step);
+        for (const auto & [dark_from, dark_to]: dark) {
+            night.moonless_hours += std::max(0.0, std::min(to, dark_to) - std::max(from, dark_from)) * 24.0;
+        }
+    }
+
+    // Illumination from the geocentric elongation, as in QSunInfo
+    const QDateTime middle = noon.addMSecs(std::llround(((longest.first + longest.second) / 2 - start) * 86400000.0));
+    const Vec3D sun = Universe::compute_sun_equ(middle);
+    const Vec3D moon_equ = Universe::compute_moon_equ(middle);
+    night.moon_illumination = (1.0 - Dot(sun, moon_equ) / (Norm(sun) * Norm(moon_equ))) / 2.0;
+
+    return night;
+}
+
+/**
+ * @brief Almanac::compute
+ * Computes `count` nights starting with the evening of `first`. Batches of nights run in a private
+ * thread pool, so that waiting here can never starve the global pool (or be starved by it).
+ */
+QVector<Almanac::Night> Almanac::compute(const QDate & first, int count) const {
+    QVector<Night> nights(std::max(count, 0));
+    Night * data = nights.data();
+
+    QThreadPool pool;
+    for (int batch = 0; batch < count; batch += Almanac::NightsPerTask) {
+        pool.start([this, data, first, batch, count]() {
+            for (int i = batch; i < std::min(count, batch + Almanac::NightsPerTask); ++i) {
+                data[i] = this->night(first.addDays(i));
+            }
+        });
+    }
+    pool.waitForDone();
+    return nights;
+}
+
+QVector<Almanac::Night> Almanac::compute_year(int year) const {
+    const QDate first(year, 1, 1);
+    return this->compute(first, first.daysTo(first.addYears(1)));
+}
+
+double Almanac::dark_hours(const QVector<Night> & nights) {
+    double total = 0;
+    for (const Night & night: nights) {
+        total += night.dark_hours;
+    }
+    return total;
+}
+
+double Almanac::moonless_hours(const QVector<Night> & nights) {
+    double total = 0;
+    for (const Night & night: nights) {
+        total += night.moonless_hours;
+    }
+    return total;
+}
+
+// A single line of CSV without the newline, the columns are in CsvHeader
+QString Almanac::csv(const Night & night) {
+    return QString("%1,%2,%3,%4,%5,%6").arg(
+        night.date.toString(Qt::ISODate),
+        night.dusk.isValid() ? night.dusk.toString(Qt::ISODate) : "",
+        night.dawn.isValid() ? night.dawn.toString(Qt::ISODate) : "",
+        QString::number(night.dark_hours, 'f', 3),
+        QString::number(night.moonless_hours, 'f', 3),
+        QString::number(night.moon_illumination, 'f', 3)
+    );
+}
+
+QString Almanac::csv(const QVector<Night> & nights) const {
+    QString result = QString(Almanac::CsvHeader) + "\n";
+    for (const Night & night: nights) {
+        result += Almanac::csv(night) + "\n";
+    }
+    return result;
+}
+
+QJsonObject Almanac::json(const QVector<Night> & nights) const {
+    QJsonArray array;
+    for (const Night & night: nights) {
+        array.append(QJsonObject {
+            {"date", night.date.toString(Qt::ISODate)},
+            {"dusk", night.dusk.isValid() ? QJsonValue(night.dusk.toString(Qt::ISODate)) : QJsonValue()},
+            {"dawn", night.dawn.isValid() ? QJsonValue(night.dawn.toString(Qt::ISODate)) : QJsonValue()},
+            {"dark_hours", night.dark_hours},
+            {"moonless_hours", night.moonless_hours},
+            {"moon_illumination", night.moon_illumination},
+        });
+    }
+
+    return QJsonObject {
+        {"latitude", this->m_latitude},
+        {"longitude", this->m_longitude},
+        {"darkness_limit", this->m_darkness_limit},
+        {"dark_hours", Almanac::dark_hours(nights)},
+        {"moonless_hours", Almanac::moonless_hours(nights)},
+        {"nights", array},
+    };
+}
@@ -0,0 +1,56 @@
+#ifndef ALMANAC_H
+#define ALMANAC_H
+
+#include <QDate>
+#include <QDateTime>
+#include <QVector>
+#include <QJsonObject>
+
+/**
+ * @brief The Almanac class computes the nightly observation windows of a station for one darkness limit:
+ *        when the Sun sinks below the limit and when it rises above it again, how long it stays below,
+ *        and how much of that time the Moon is below the horizon.
+ *        A night runs from local mean noon to the next one and is named by the date of the evening.
+ *        Nights do not depend on each other, so a range of them is spread over all cores.
+ */
+class Almanac {
+public:
+    struct Night {
+        QDate date;
+        QDateTime dusk;                     // Sun sinks below the darkness limit, invalid if it does not
+        QDateTime dawn;                     // Sun rises above the darkness limit, invalid if it does not
+        double dark_hours = 0;              // Time with the Sun below the darkness limit
+        double moonless_hours = 0;          // Part of the dark time with the Moon below the horizon
+        double moon_illumination = 0;       // Illuminated fraction of the Moon in the middle of the night
+    };
+
+private:
+    double m_latitude;
+    double m_longitude;
+    double m_darkness_limit;
+
+public:
+    constexpr static int MoonStep = 120;                // Time in s: resolution of the Moon overlap
+    constexpr static double MoonHorizon = -0.5;         // Angle in degrees: the Moon is up above this, as for moonrise
+    constexpr static int NightsPerTask = 8;
+    constexpr static char CsvHeader[] = "date,dusk,dawn,dark_hours,moonless_hours,moon_illumination";
+
+    Almanac(double latitude, double longitude, double darkness_limit);
+
+    inline double latitude(void) const { return this->m_latitude; }
+    inline double longitude(void) const { return this->m_longitude; }
+    inline double darkness_limit(void) const { return this->m_darkness_limit; }
+
+    Night night(const QDate & date) const;
+    QVector<Night> compute(const QDate & first, int count) const;
+    QVector<Night> compute_year(int year) const;
+
+    static double dark_hours(const QVector<Night> & nights);
+    static double moonless_hours(const QVector<Night> & nights);
+
+    static QString csv(const Night & night);
+    QString csv(const QVector<Night> & nights) const;
+    QJsonObject json(const QVector<Night> & nights) const;
+};
+
+#endif // ALMANAC_H
@@ -18,7 +18,7 @@ float DomeState::deciint(const QByteArray & chunk) {
 }
 
 bool DomeState::is_valid(void) const {
-    logger.detail(Concern::SerialPort, QString("State age is %1").arg(this->age()));
+    logger.detail(Concern::SerialPort, [this] { return QString("State age is %1").arg(this->age()); });
     return (this->m_valid && (this->age() < 2.0));
 }
 
@@ -49,7 +49,7 @@ DomeStateS::DomeStateS(const QByteArray & response):
     memcpy(&this->m_time_alive, response.mid(4, 4), 4);
 
     this->m_valid     = true;
-    logger.debug(Concern::SerialPort, QString("S state received: %1").arg(QString(this->full_text())));
+    logger.debug(Concern::SerialPort, [this] { return QString("S state received: %1").arg(QString(this->full_text())); });
 }
 
 // Return textual representation of the state (three bytes as received, char for true, dash for false)
@@ -121,11 +121,13 @@ DomeStateT::DomeStateT(const QByteArray & response):
     this->m_humi_SHT31 = DomeStateT::deciint(response.mid(7, 2));
 
     this->m_valid      = true;
-    logger.debug(Concern::SerialPort, QString("T state received: %1 %2 %3 %4")
-                 .arg(this->m_temp_lens, 4, 'f', 1)
-                 .arg(this->m_temp_CPU, 4, 'f', 1)
-                 .arg(this->m_temp_SHT31, 4, 'f', 1)
-                 .arg(this->m_humi_SHT31, 4, 'f', 1));
+    logger.debug(Concern::SerialPort, [this] {
+        return QString("T state received: %1 %2 %3 %4")
+            .arg(this->m_temp_lens, 4, 'f', 1)
+            .arg(this->m_temp_CPU, 4, 'f', 1)
+            .arg(this->m_temp_SHT31, 4, 'f', 1)
+            .arg(this->m_humi_SHT31, 4, 'f', 1);
+    });
 }
 
 float DomeStateT::temperature_lens(void) const { return this->m_temp_lens; }
@@ -172,7 +174,7 @@ DomeStateZ::DomeStateZ(const QByteArray & response):
 #endif
 
     this->m_valid = true;
-    logger.debug(Concern::SerialPort, QString("Z state received: %1").arg(this->m_shaft_position));
+    logger.debug(Concern::SerialPort, [this] { return QString("Z state received: %1").arg(this->m_shaft_position); });
 }
 
 short int DomeStateZ::shaft_position(void) const {
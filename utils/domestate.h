@@ -62,6 +62,11 @@ public:
 
     inline unsigned int time_alive(void) const              { return this->m_time_alive / 75; };
 
+    // Raw status bytes as received
+    inline unsigned char basic(void) const                  { return this->m_basic; };
+    inline unsigned char env(void) const                    { return this->m_env; };
+    inline unsigned char errors(void) const                 { return this->m_errors; };
+
     QByteArray full_text(void) const;
     QJsonValue json(void) const override;
 };
@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <cmath>
+#include <QMutexLocker>
+
+#include "utils/ephemeriscache.h"
+
+
+QJsonObject EphemerisCache::Summary::json(void) const {
+    return QJsonObject {
+        {"from", this->from.toString(Qt::ISODate)},
+        {"to", this->to.toString(Qt::ISODate)},
+        {"segments", this->segments},
+        {"rejected", this->rejected},
+        {"sun_error", this->sun_error},
+        {"moon_error", this->moon_error},
+    };
+}
+
+EphemerisCache::EphemerisCache(void):
+    m_enabled(true),
+    m_max_error(EphemerisCache::DefaultMaxError)
+{}
+
+void EphemerisCache::configure(bool enabled, double max_error) {
+    QMutexLocker lock(&this->m_mutex);
+    this->m_enabled = enabled;
+    this->m_max_error = max_error;
+    if (!enabled) {
+        this->m_window.reset();
+    }
+}
+
+std::shared_ptr<const EphemerisCache::Window> EphemerisCache::window(void) const {
+    QMutexLocker lock(&this->m_mutex);
+    return this->m_window;
+}
+
+// Largest angle between the fit and the direct computation, in arcseconds, sampled between the nodes
+double EphemerisCache::check(Cheb3D & fit, C3Dfunct function, double from, double to) {
+    double error = 0;
+    for (int i = 0; i < EphemerisCache::CheckPoints; ++i) {
+        const double t = from + (to - from) * (i + 0.5) / EphemerisCache::CheckPoints;
+        const Vec3D approximate = fit.Value(t);
+        const Vec3D exact = function(t);
+        error = std::max(error, std::atan2(Norm(Cross(approximate, exact)), Dot(approximate, exact)) * Arcs);
+    }
+    return error;
+}
+
+/**
+ * @brief EphemerisCache::fit
+ * Fits `function` over [from, to], halving the segment until it meets `max_error`.
+ * @param error         raised to the largest error of the accepted fits
+ * @param rejected      incremented for every segment that could not meet the bound
+ */
+void EphemerisCache::fit(C3Dfunct function, double from, double to, double max_error,
+                         std::vector<Segment> & segments, double & error, int & rejected) const {
+    auto cheb = std::make_shared<Cheb3D>(function, EphemerisCache::Degree, to - from);
+    cheb->Fit(from, to);
+    const double segment_error = EphemerisCache::check(*cheb, function, from, to);
+
+    if (segment_error <= max_error) {
+        segments.push_back({from, to, cheb});
+        error = std::max(error, segment_error);
+    } else if ((to - from) / 2 >= EphemerisCache::MinSegmentLength) {
+        const double middle = (from + to) / 2;
+        this->fit(function, from, middle, max_error, segments, error, rejected);
+        this->fit(function, middle, to, max_error, segments, error, rejected);
+    } else {
+        segments.push_back({from, to, nullptr});
+        rejected++;
+    }
+}
+
+/**
+ * @brief EphemerisCache::refresh
+ * Fits a new window around `now` and swaps it in. Takes a few hundred direct evaluations,
+ * so it should not be run on the GUI thread. Concurrent refreshes are serialized.
+ */
+EphemerisCache::Summary EphemerisCache::refresh(const QDateTime & now) {
+    QMutexLocker refresh_lock(&this->m_refresh_mutex);
+
+    bool enabled;
+    double max_error;
+    {
+        QMutexLocker lock(&this->m_mutex);
+        enabled = this->m_enabled;
+        max_error = this->m_max_error;
+    }
+
+    Summary summary;
+    if (!enabled) {
+        return summary;
+    }
+
+    auto window = std::make_shared<Window>();
+    window->from = Universe::mjd(now) - EphemerisCache::WindowBefore;
+    window->to = window->from + EphemerisCache::WindowLength;
+
+    const int count = static_cast<int>(std::ceil(EphemerisCache::WindowLength / EphemerisCache::SegmentLength));
+    for (int i = 0; i < count; ++i) {
+        const double from = window->from + i * EphemerisCache::SegmentLength;
+        const double to = std::min(window->to, from + EphemerisCache::SegmentLength);
+        this->fit(Universe::sun_equ_direct, from, to, max_error, window->sun, summary.sun_error, summary.rejected);
+        this->fit(Universe::moon_equ_direct, from, to, max_error, window->moon, summary.moon_error, summary.rejected);
+    }
+
+    summary.from = now.addSecs(std::llround(-EphemerisCache::WindowBefore * 86400));
+    summary.to = summary.from.addSecs(std::llround(EphemerisCache::WindowLength * 86400));
+    summary.segments = static_cast<int>(window->sun.size() + window->moon.size());
+
+    QMutexLocker lock(&this->m_mutex);
+    if (this->m_enabled) {
+        this->m_window = window;
+    }
+    return summary;
+}
+
+Vec3D EphemerisCache::evaluate(const std::vector<Segment> & segments, double mjd, C3Dfunct function) const {
+    auto segment = std::lower_bound(segments.cbegin(), segments.cend(), mjd,
+                                    [](const Segment & segment, double t) { return segment.to < t; });
+    if ((segment != segments.cend()) && (segment->from <= mjd) && segment->fit) {
+        this->m_hits.fetch_add(1, std::memory_order_relaxed);
+        return segment->fit->Value(mjd);
+    } else {
+        this->m_misses.fetch_add(1, std::memory_order_relaxed);
+        return function(mjd);
+    }
+}
+
+Vec3D EphemerisCache::sun_equ(double mjd) const {
+    const auto window = this->window();
+    return window ? this->evaluate(window->sun, mjd, Universe::sun_equ_direct) : Universe::sun_equ_direct(mjd);
+}
+
+Vec3D EphemerisCache::moon_equ(double mjd) const {
+    const auto window = this->window();
+    return window ? this->evaluate(window->moon, mjd, Universe::moon_equ_direct) : Universe::moon_equ_direct(mjd);
+}
+
+// Batch versions, the window is only looked up once
+void EphemerisCache::evaluate(const Window * window, const std::vector<Segment> Window::* segments, C3Dfunct function,
+                              const double * mjd, qsizetype count, double * x, double * y, double * z) const {
+    for (qsizetype i = 0; i < count; ++i) {
+        const Vec3D position = window ? this->evaluate(window->*segments, mjd[i], function) : function(mjd[i]);
+        x[i] = position[::x];
+        y[i] = position[::y];
+        z[i] = position[::z];
+    }
+}
+
+void EphemerisCache::sun_equ(const double * mjd, qsizetype count, double * x, double * y, double * z) const {
+    this->evaluate(this->window().get(), &Window::sun, Universe::sun_equ_direct, mjd, count, x, y, z);
+}
+
+void EphemerisCache::moon_equ(const double * mjd, qsizetype count, double * x, double * y, double * z) const {
+    this->evaluate(this->window().get(), &Window::moon, Universe::moon_equ_direct, mjd, count, x, y, z);
+}
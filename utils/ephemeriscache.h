@@ -0,0 +1,95 @@
+#ifndef EPHEMERISCACHE_H
+#define EPHEMERISCACHE_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <QMutex>
+#include <QDateTime>
+#include <QJsonObject>
+
+#include "utils/universe.h"
+
+/**
+ * @brief The EphemerisCache class answers equatorial positions of the Sun and the Moon from Chebyshev fits
+ *        (Cheb3D) over a sliding window, instead of evaluating MiniSun / MiniMoon for every query.
+ *        The positions do not depend on the station, so a single cache serves every caller of Universe.
+ *        The window is split into segments, each fit is checked against the direct computation
+ *        and split further until it meets the error bound. Segments that never do, and times outside
+ *        the window, fall back to the direct computation.
+ *        refresh() refits the window and is meant to be run in the background, queries are thread-safe
+ *        and keep using the previous window until the new one is swapped in.
+ *        The cache only counts its hits and misses, publishing them is up to the owner,
+ *        so that it can be used without the metrics registry (and the GUI behind the logger).
+ */
+class EphemerisCache {
+public:
+    struct Summary {
+        QDateTime from;
+        QDateTime to;
+        int segments = 0;
+        int rejected = 0;
+        double sun_error = 0;
+        double moon_error = 0;
+
+        QJsonObject json(void) const;
+    };
+
+private:
+    struct Segment {
+        double from;
+        double to;
+        std::shared_ptr<Cheb3D> fit;                        // nullptr if the fit did not meet the error bound
+    };
+
+    struct Window {
+        double from;
+        double to;
+        std::vector<Segment> sun;
+        std::vector<Segment> moon;
+    };
+
+    mutable QMutex m_mutex;
+    std::shared_ptr<const Window> m_window;
+    bool m_enabled;
+    double m_max_error;
+
+    QMutex m_refresh_mutex;
+
+    mutable std::atomic<quint64> m_hits = 0;
+    mutable std::atomic<quint64> m_misses = 0;
+
+    std::shared_ptr<const Window> window(void) const;
+    void fit(C3Dfunct function, double from, double to, double max_error,
+             std::vector<Segment> & segments, double & error, int & rejected) const;
+    Vec3D evaluate(const std::vector<Segment> & segments, double mjd, C3Dfunct function) const;
+    void evaluate(const Window * window, const std::vector<Segment> Window::* segments, C3Dfunct function,
+                  const double * mjd, qsizetype count, double * x, double * y, double * z) const;
+    static double check(Cheb3D & fit, C3Dfunct function, double from, double to);
+
+public:
+    constexpr static double WindowBefore = 0.25;            // Time in days: the window starts this long before the refresh
+    constexpr static double WindowLength = 2.0;             // Time in days
+    constexpr static double SegmentLength = 0.25;           // Time in days: length of a segment before any splitting
+    constexpr static double MinSegmentLength = 1.0 / 96.0;  // Time in days: segments are not split below this
+    constexpr static int Degree = 10;                       // Degree of the Chebyshev polynomials
+    constexpr static int CheckPoints = 8;                   // Number of points per segment compared to the direct computation
+    constexpr static double DefaultMaxError = 1.0;          // Angle in arcseconds
+    constexpr static int RefreshInterval = 3600000;         // Time in ms: how often the window is moved
+
+    EphemerisCache(void);
+
+    void configure(bool enabled, double max_error);
+    inline bool is_enabled(void) const { QMutexLocker lock(&this->m_mutex); return this->m_enabled; }
+    inline quint64 hits(void) const { return this->m_hits.load(std::memory_order_relaxed); }
+    inline quint64 misses(void) const { return this->m_misses.load(std::memory_order_relaxed); }
+
+    Summary refresh(const QDateTime & now = QDateTime::currentDateTimeUtc());
+
+    Vec3D sun_equ(double mjd) const;
+    Vec3D moon_equ(double mjd) const;
+    void sun_equ(const double * mjd, qsizetype count, double * x, double * y, double * z) const;
+    void moon_equ(const double * mjd, qsizetype count, double * x, double * y, double * z) const;
+};
+
+#endif // EPHEMERISCACHE_H
@@ -0,0 +1,40 @@
+#include <QtEndian>
+
+#include "gzip.h"
+
+
+quint32 Gzip::crc32(QByteArrayView data, quint32 crc) {
+    crc = ~crc;
+    for (const char byte: data) {
+        crc = Gzip::Crc32Table[(crc ^ static_cast<unsigned char>(byte)) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/**
+ * @brief Gzip::compress
+ * qCompress returns a 4-byte length, a 2-byte zlib header, the deflate data and a 4-byte Adler-32.
+ * Only the deflate data is kept.
+ * @return a complete gzip member, or an empty array if the compression failed
+ */
+QByteArray Gzip::compress(QByteArrayView data, int level) {
+    const QByteArray zlib = qCompress(reinterpret_cast<const uchar *>(data.data()), data.size(), level);
+    if (zlib.size() < 10) {
+        return QByteArray();
+    }
+    const QByteArrayView deflate = QByteArrayView(zlib).sliced(6, zlib.size() - 10);
+
+    QByteArray gzip;
+    gzip.reserve(deflate.size() + 18);
+
+    // Magic, deflate method, no flags, no timestamp, no extra flags, unknown OS
+    constexpr char header[10] = {'\x1F', '\x8B', '\x08', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\xFF'};
+    gzip.append(header, sizeof(header));
+    gzip.append(deflate);
+
+    char trailer[8];
+    qToLittleEndian<quint32>(Gzip::crc32(data), trailer);
+    qToLittleEndian<quint32>(static_cast<quint32>(data.size()), trailer + 4);
+    gzip.append(trailer, sizeof(trailer));
+    return gzip;
+}
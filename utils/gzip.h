@@ -0,0 +1,31 @@
+#ifndef GZIP_H
+#define GZIP_H
+
+#include <array>
+#include <QByteArray>
+#include <QByteArrayView>
+
+/**
+ * Gzip (RFC 1952) streams built on top of qCompress, so that no zlib headers are needed:
+ * the raw deflate data is taken from the zlib stream produced by Qt and wrapped
+ * in a gzip header and a CRC-32 trailer.
+ */
+namespace Gzip {
+    // Reflected CRC-32 (polynomial 0xEDB88320) lookup table
+    constexpr std::array<quint32, 256> Crc32Table = [] {
+        std::array<quint32, 256> table{};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 1) ? (0xEDB88320u ^ (crc >> 1)) : (crc >> 1);
+            }
+            table[i] = crc;
+        }
+        return table;
+    }();
+
+    quint32 crc32(QByteArrayView data, quint32 crc = 0);
+    QByteArray compress(QByteArrayView data, int level = -1);
+};
+
+#endif // GZIP_H
@@ -0,0 +1,185 @@
+#include <QSaveFile>
+#include <QJsonDocument>
+
+#include "utils/heartbeatbuffer.h"
+#include "logging/eventlogger.h"
+
+extern EventLogger logger;
+
+
+HeartbeatBuffer::HeartbeatBuffer(QObject * parent, const QString & filename):
+    QObject(parent),
+    m_filename(filename),
+    m_first(0),
+    m_capacity(HeartbeatBuffer::DefaultCapacity),
+    m_dead_lines(0),
+    m_dropped(0)
+{}
+
+HeartbeatBuffer::~HeartbeatBuffer(void) {
+    if (this->m_file != nullptr) {
+        this->m_file->close();
+        delete this->m_file;
+    }
+}
+
+void HeartbeatBuffer::initialize(void) {
+    this->load();
+    this->compact();
+}
+
+/**
+ * @brief HeartbeatBuffer::load
+ * Replays the file. Malformed lines (typically a line cut short by a crash) are skipped.
+ */
+void HeartbeatBuffer::load(void) {
+    QFile file(this->m_filename);
+    if (!file.exists()) {
+        return;
+    }
+
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        logger.error(Concern::Heartbeat, QString("Could not open heartbeat buffer '%1': %2").arg(this->m_filename, file.errorString()));
+        return;
+    }
+
+    int malformed = 0;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        if (line.startsWith('{') && line.endsWith('}')) {
+            this->m_heartbeats.push_back(line);
+        } else if (line.startsWith('-')) {
+            bool ok;
+            const int count = line.mid(1).toInt(&ok);
+            if (ok) {
+                this->m_heartbeats.erase(this->m_heartbeats.begin(),
+                                         this->m_heartbeats.begin() + qMin<std::size_t>(count, this->m_heartbeats.size()));
+            } else {
+                malformed++;
+            }
+        } else if (!line.isEmpty()) {
+            malformed++;
+        }
+    }
+
+    if (!this->m_heartbeats.empty()) {
+        logger.info(Concern::Heartbeat, QString("Heartbeat buffer '%1' loaded, %2 heartbeats waiting")
+                                            .arg(this->m_filename).arg(this->m_heartbeats.size()));
+    }
+    if (malformed > 0) {
+        logger.warning(Concern::Heartbeat, QString("Skipped %1 malformed lines in the heartbeat buffer").arg(malformed));
+    }
+}
+
+void HeartbeatBuffer::open(void) {
+    this->m_file = new QFile(this->m_filename);
+    if (!this->m_file->open(QIODevice::Append | QIODevice::Text)) {
+        logger.error(Concern::Heartbeat, QString("Could not open heartbeat buffer '%1' for writing: %2")
+                                             .arg(this->m_filename, this->m_file->errorString()));
+    }
+}
+
+void HeartbeatBuffer::write(const QByteArray & line) {
+    if (this->m_file == nullptr) {
+        this->open();
+    }
+    if (this->m_file->isOpen()) {
+        this->m_file->write(line);
+        this->m_file->write("\n");
+        this->m_file->flush();
+    }
+}
+
+void HeartbeatBuffer::set_capacity(int capacity) {
+    this->m_capacity = qMax(1, capacity);
+    const int excess = this->count() - this->m_capacity;
+    if (excess > 0) {
+        this->m_dropped += excess;
+        this->remove(excess);
+    }
+}
+
+void HeartbeatBuffer::append(const QJsonObject & heartbeat) {
+    const QByteArray line = QJsonDocument(heartbeat).toJson(QJsonDocument::Compact);
+    this->m_heartbeats.push_back(line);
+    this->write(line);
+
+    if (this->count() > this->m_capacity) {
+        this->m_dropped++;
+        this->remove(1);
+    }
+}
+
+/**
+ * @brief HeartbeatBuffer::batch
+ * Joins the oldest heartbeats into a JSON array, without parsing them again
+ * @param max_count     at most this many heartbeats
+ * @param max_size      at most this many bytes, but always at least one heartbeat
+ * @param count         set to the number of heartbeats in the batch
+ * @param end           set to the sequence number following the last heartbeat in the batch, for remove_until
+ */
+QByteArray HeartbeatBuffer::batch(int max_count, qint64 max_size, int & count, qint64 & end) const {
+    QByteArray result = "[";
+    count = 0;
+    for (const QByteArray & heartbeat: this->m_heartbeats) {
+        if ((count >= max_count) || ((count > 0) && (result.size() + heartbeat.size() + 2 > max_size))) {
+            break;
+        }
+        if (count > 0) {
+            result += ',';
+        }
+        result += heartbeat;
+        count++;
+    }
+    result += ']';
+    end = this->m_first + count;
+    return result;
+}
+
+// Removes the oldest heartbeats, typically after they were uploaded
+void HeartbeatBuffer::remove(int count) {
+    count = qMin(count, this->count());
+    if (count <= 0) {
+        return;
+    }
+
+    this->m_heartbeats.erase(this->m_heartbeats.begin(), this->m_heartbeats.begin() + count);
+    this->m_first += count;
+    this->write(QByteArray::number(-count));
+    this->m_dead_lines += count + 1;
+
+    if (this->m_heartbeats.empty() || (this->m_dead_lines > HeartbeatBuffer::CompactThreshold)) {
+        this->compact();
+    }
+}
+
+// Removes the heartbeats of a batch, except those that have been dropped since it was assembled
+void HeartbeatBuffer::remove_until(qint64 end) {
+    this->remove(static_cast<int>(qMin<qint64>(end - this->m_first, this->count())));
+}
+
+// Rewrites the file atomically with only the heartbeats still waiting
+void HeartbeatBuffer::compact(void) {
+    if (this->m_file != nullptr) {
+        this->m_file->close();
+        delete this->m_file;
+        this->m_file = nullptr;
+    }
+
+    QSaveFile file(this->m_filename);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        for (const QByteArray & heartbeat: this->m_heartbeats) {
+            file.write(heartbeat);
+            file.write("\n");
+        }
+        if (file.commit()) {
+            this->m_dead_lines = 0;
+        } else {
+            logger.error(Concern::Heartbeat, QString("Could not compact the heartbeat buffer: %1").arg(file.errorString()));
+        }
+    } else {
+        logger.error(Concern::Heartbeat, QString("Could not compact the heartbeat buffer: %1").arg(file.errorString()));
+    }
+
+    this->open();
+}
@@ -0,0 +1,56 @@
+#ifndef HEARTBEATBUFFER_H
+#define HEARTBEATBUFFER_H
+
+#include <deque>
+#include <QObject>
+#include <QFile>
+#include <QJsonObject>
+
+/**
+ * @brief The HeartbeatBuffer class keeps heartbeats that could not be delivered, oldest first,
+ *        so that they can be uploaded in batches once the server is reachable again.
+ *        It is backed by an append-only file: a heartbeat is appended as a line of compact JSON,
+ *        removal of the oldest n heartbeats as a line "-n". On start the file is replayed and compacted.
+ *        The buffer is bounded, when full the oldest heartbeats are dropped.
+ *        Heartbeats are numbered in memory, so that a batch that was uploaded while older ones were dropped
+ *        removes only what it contained.
+ */
+class HeartbeatBuffer: public QObject {
+    Q_OBJECT
+private:
+    constexpr static int CompactThreshold = 1000;           // Number of dead lines after which the file is rewritten
+
+    QString m_filename;
+    QFile * m_file = nullptr;
+    std::deque<QByteArray> m_heartbeats;
+    qint64 m_first;                                         // Sequence number of the oldest heartbeat, grows with every removal
+    int m_capacity;
+    int m_dead_lines;
+    int m_dropped;
+
+    void load(void);
+    void open(void);
+    void write(const QByteArray & line);
+
+public:
+    constexpr static int DefaultCapacity = 10080;           // A week of heartbeats at the default interval
+
+    explicit HeartbeatBuffer(QObject * parent, const QString & filename);
+    ~HeartbeatBuffer(void);
+
+    void initialize(void);
+    void set_capacity(int capacity);
+
+    inline int count(void) const { return static_cast<int>(this->m_heartbeats.size()); }
+    inline bool is_empty(void) const { return this->m_heartbeats.empty(); }
+    inline int dropped(void) const { return this->m_dropped; }
+    inline int capacity(void) const { return this->m_capacity; }
+
+    void append(const QJsonObject & heartbeat);
+    QByteArray batch(int max_count, qint64 max_size, int & count, qint64 & end) const;
+    void remove(int count);
+    void remove_until(qint64 end);
+    void compact(void);
+};
+
+#endif // HEARTBEATBUFFER_H
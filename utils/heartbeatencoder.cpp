@@ -0,0 +1,79 @@
+#include "utils/heartbeatencoder.h"
+
+
+HeartbeatEncoder::HeartbeatEncoder(int keyframe_interval):
+    m_keyframe_interval(qMax(1, keyframe_interval)),
+    m_since_keyframe(0),
+    m_force_keyframe(true)
+{}
+
+void HeartbeatEncoder::set_keyframe_interval(int interval) {
+    this->m_keyframe_interval = qMax(1, interval);
+}
+
+/**
+ * @brief HeartbeatEncoder::encode
+ * Encodes the next heartbeat, either as a delta or as a keyframe
+ * @param heartbeat     full heartbeat
+ * @param keyframe      set to true if the full heartbeat is returned
+ */
+QJsonObject HeartbeatEncoder::encode(const QJsonObject & heartbeat, bool & keyframe) {
+    keyframe = this->m_force_keyframe || this->m_acknowledged.isEmpty() || (this->m_since_keyframe + 1 >= this->m_keyframe_interval);
+    if (keyframe) {
+        this->m_since_keyframe = 0;
+        this->m_force_keyframe = false;
+        return heartbeat;
+    }
+
+    this->m_since_keyframe++;
+    QJsonObject delta = HeartbeatEncoder::diff(this->m_acknowledged, heartbeat);
+    for (const QString & key: HeartbeatEncoder::AlwaysSent) {
+        delta[key] = heartbeat[key];
+    }
+    delta["base"] = this->m_acknowledged["time"];
+    return delta;
+}
+
+/**
+ * @brief HeartbeatEncoder::acknowledge
+ * Makes a full heartbeat the base for the following deltas. Replies may arrive out of order,
+ * an acknowledgement older than the current base is ignored.
+ */
+void HeartbeatEncoder::acknowledge(const QJsonObject & heartbeat) {
+    // ISO 8601 in UTC, so the strings compare like the times
+    if (this->m_acknowledged.isEmpty() || (heartbeat["time"].toString() >= this->m_acknowledged["time"].toString())) {
+        this->m_acknowledged = heartbeat;
+    }
+}
+
+// Called when a delta was not accepted, the server may have lost its base
+void HeartbeatEncoder::reset(void) {
+    this->m_force_keyframe = true;
+}
+
+/**
+ * @brief HeartbeatEncoder::diff
+ * Fields of current that differ from base. Nested objects are compared field by field,
+ * arrays and other values as a whole; fields missing from current are set to null.
+ */
+QJsonObject HeartbeatEncoder::diff(const QJsonObject & base, const QJsonObject & current) {
+    QJsonObject result;
+    for (auto field = current.constBegin(); field != current.constEnd(); ++field) {
+        const QJsonValue old = base.value(field.key());
+        if (old == field.value()) {
+            continue;
+        }
+
+        if (old.isObject() && field.value().isObject()) {
+            result[field.key()] = HeartbeatEncoder::diff(old.toObject(), field.value().toObject());
+        } else {
+            result[field.key()] = field.value();
+        }
+    }
+    for (auto field = base.constBegin(); field != base.constEnd(); ++field) {
+        if (!current.contains(field.key())) {
+            result[field.key()] = QJsonValue::Null;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,37 @@
+#ifndef HEARTBEATENCODER_H
+#define HEARTBEATENCODER_H
+
+#include <QJsonObject>
+#include <QStringList>
+
+/**
+ * @brief The HeartbeatEncoder class turns full heartbeats into deltas against the last heartbeat
+ *        that the server acknowledged. A delta is a JSON merge patch (RFC 7386) of the changed fields,
+ *        plus the fields in AlwaysSent and "base" with the time of the acknowledged
+ *        heartbeat it applies to. Every keyframe_interval-th heartbeat, and whenever the base is
+ *        unknown or a delta was not accepted, the full heartbeat is sent instead.
+ */
+class HeartbeatEncoder {
+private:
+    QJsonObject m_acknowledged;
+    int m_keyframe_interval;
+    int m_since_keyframe;
+    bool m_force_keyframe;
+
+public:
+    constexpr static int DefaultKeyframeInterval = 10;
+    inline const static QStringList AlwaysSent = {"protocol", "time"};
+
+    explicit HeartbeatEncoder(int keyframe_interval = HeartbeatEncoder::DefaultKeyframeInterval);
+
+    void set_keyframe_interval(int interval);
+    inline int keyframe_interval(void) const { return this->m_keyframe_interval; }
+
+    QJsonObject encode(const QJsonObject & heartbeat, bool & keyframe);
+    void acknowledge(const QJsonObject & heartbeat);
+    void reset(void);
+
+    static QJsonObject diff(const QJsonObject & base, const QJsonObject & current);
+};
+
+#endif // HEARTBEATENCODER_H
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+#include "utils/histogram.h"
+
+
+Histogram::Histogram(void) {
+    this->reset();
+}
+
+void Histogram::reset(void) {
+    this->m_buckets.fill(0);
+    this->m_count = 0;
+    this->m_sum = 0;
+    this->m_min = std::numeric_limits<quint64>::max();
+    this->m_max = 0;
+}
+
+std::size_t Histogram::index(quint64 value) {
+    if (value < Histogram::SubBucketCount) {
+        return value;
+    }
+    // Keep the five most significant bits, the top one is always set
+    const unsigned int shift = std::bit_width(value) - Histogram::SubBucketBits;
+    const quint64 top = value >> shift;
+    return Histogram::SubBucketCount + (shift - 1) * Histogram::SubBucketHalf + (top - Histogram::SubBucketHalf);
+}
+
+// The highest value that falls into the bucket
+quint64 Histogram::upper_bound(std::size_t index) {
+    if (index < Histogram::SubBucketCount) {
+        return index;
+    }
+    const std::size_t offset = index - Histogram::SubBucketCount;
+    const unsigned int shift = offset / Histogram::SubBucketHalf + 1;
+    const quint64 top = offset % Histogram::SubBucketHalf + Histogram::SubBucketHalf;
+    return ((top + 1) << shift) - 1;
+}
+
+void Histogram::record(quint64 value) {
+    this->m_buckets[Histogram::index(value)]++;
+    this->m_count++;
+    this->m_sum += value;
+    this->m_min = std::min(this->m_min, value);
+    this->m_max = std::max(this->m_max, value);
+}
+
+double Histogram::mean(void) const {
+    return (this->m_count == 0) ? std::numeric_limits<double>::quiet_NaN() : static_cast<double>(this->m_sum) / this->m_count;
+}
+
+/**
+ * @brief Histogram::percentile
+ * @param percent 0 to 100
+ * @return the value below which `percent` of recorded values fall, rounded up to the bucket boundary
+ */
+quint64 Histogram::percentile(double percent) const {
+    if (this->m_count == 0) {
+        return 0;
+    }
+
+    const quint64 target = std::max<quint64>(1, static_cast<quint64>(percent / 100.0 * this->m_count + 0.5));
+    quint64 seen = 0;
+    for (std::size_t i = 0; i < Histogram::BucketCount; ++i) {
+        seen += this->m_buckets[i];
+        if (seen >= target) {
+            return std::min(Histogram::upper_bound(i), this->m_max);
+        }
+    }
+    return this->m_max;
+}
+
+// Summary for heartbeats and diagnostics, values are divided by `scale`
+QJsonObject Histogram::json(double scale) const {
+    if (this->m_count == 0) {
+        return QJsonObject {{"n", 0}};
+    }
+    return QJsonObject {
+        {"n", static_cast<qint64>(this->m_count)},
+        {"p50", this->percentile(50) / scale},
+        {"p90", this->percentile(90) / scale},
+        {"p99", this->percentile(99) / scale},
+        {"max", this->m_max / scale},
+    };
+}
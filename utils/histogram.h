@@ -0,0 +1,45 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <array>
+#include <QtGlobal>
+#include <QJsonObject>
+
+/**
+ * @brief The Histogram class is a fixed-size log-linear histogram in the spirit of HdrHistogram:
+ *        values below 32 are counted exactly, every further power of two is split into 16 buckets,
+ *        so any recorded value is known to within 1/16 of itself. Recording does not allocate.
+ */
+class Histogram {
+private:
+    constexpr static unsigned int SubBucketBits = 5;
+    constexpr static quint64 SubBucketCount = 1 << SubBucketBits;       // 32 exact values
+    constexpr static quint64 SubBucketHalf = SubBucketCount / 2;        // 16 buckets per power of two
+    constexpr static unsigned int MaxShift = 64 - SubBucketBits;
+    constexpr static std::size_t BucketCount = SubBucketCount + MaxShift * SubBucketHalf;
+
+    std::array<quint64, BucketCount> m_buckets;
+    quint64 m_count;
+    quint64 m_sum;
+    quint64 m_min;
+    quint64 m_max;
+
+    static std::size_t index(quint64 value);
+    static quint64 upper_bound(std::size_t index);
+
+public:
+    Histogram(void);
+
+    void record(quint64 value);
+    void reset(void);
+
+    inline quint64 count(void) const { return this->m_count; }
+    inline quint64 min(void) const { return this->m_min; }
+    inline quint64 max(void) const { return this->m_max; }
+    double mean(void) const;
+    quint64 percentile(double percent) const;
+
+    QJsonObject json(double scale = 1.0) const;
+};
+
+#endif // HISTOGRAM_H
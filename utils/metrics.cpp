@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QJsonArray>
+#include <QMutexLocker>
+
+#include "utils/metrics.h"
+
+
+Metrics::Histogram::Histogram(const std::vector<double> & bounds):
+    m_bounds(bounds),
+    m_buckets(new std::atomic<quint64>[bounds.size() + 1])
+{
+    std::sort(this->m_bounds.begin(), this->m_bounds.end());
+    for (std::size_t i = 0; i <= this->m_bounds.size(); ++i) {
+        this->m_buckets[i] = 0;
+    }
+}
+
+void Metrics::Histogram::observe(double value) {
+    const std::size_t bucket = std::lower_bound(this->m_bounds.cbegin(), this->m_bounds.cend(), value) - this->m_bounds.cbegin();
+    this->m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    this->m_count.fetch_add(1, std::memory_order_relaxed);
+    this->m_sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+// Number of observations less than or equal to the bucket's upper bound
+quint64 Metrics::Histogram::cumulative(std::size_t bucket) const {
+    quint64 total = 0;
+    for (std::size_t i = 0; i <= bucket; ++i) {
+        total += this->m_buckets[i].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+QJsonObject Metrics::Histogram::json(void) const {
+    QJsonArray bounds;
+    QJsonArray buckets;
+    for (std::size_t i = 0; i <= this->m_bounds.size(); ++i) {
+        if (i < this->m_bounds.size()) {
+            bounds.append(this->m_bounds[i]);
+        }
+        buckets.append(static_cast<qint64>(this->m_buckets[i].load(std::memory_order_relaxed)));
+    }
+    return QJsonObject {
+        {"n", static_cast<qint64>(this->count())},
+        {"sum", this->sum()},
+        {"le", bounds},
+        {"b", buckets},
+    };
+}
+
+Metrics::Counter & Metrics::counter(Concern concern, const QString & name) {
+    QMutexLocker lock(&this->m_mutex);
+    auto & counter = this->m_counters[Key(concern, name)];
+    if (!counter) {
+        counter = std::make_unique<Counter>();
+    }
+    return *counter;
+}
+
+Metrics::Gauge & Metrics::gauge(Concern concern, const QString & name) {
+    QMutexLocker lock(&this->m_mutex);
+    auto & gauge = this->m_gauges[Key(concern, name)];
+    if (!gauge) {
+        gauge = std::make_unique<Gauge>();
+    }
+    return *gauge;
+}
+
+// The bounds are fixed by the first registration
+Metrics::Histogram & Metrics::histogram(Concern concern, const QString & name, const std::vector<double> & bounds) {
+    QMutexLocker lock(&this->m_mutex);
+    auto & histogram = this->m_histograms[Key(concern, name)];
+    if (!histogram) {
+        histogram = std::make_unique<Histogram>(bounds);
+    }
+    return *histogram;
+}
+
+/**
+ * @brief Metrics::json
+ * Snapshot for the heartbeat: {concern: {name: value}}, histograms as {n, sum, le, b}
+ * with per-bucket (not cumulative) counts and a final bucket for values above the last bound
+ */
+QJsonObject Metrics::json(void) const {
+    QMutexLocker lock(&this->m_mutex);
+    QMap<QString, QJsonObject> concerns;
+    for (auto && [key, counter]: this->m_counters) {
+        concerns[EventLogger::Concerns[key.first].name][key.second] = static_cast<qint64>(counter->value());
+    }
+    for (auto && [key, gauge]: this->m_gauges) {
+        concerns[EventLogger::Concerns[key.first].name][key.second] = gauge->value();
+    }
+    for (auto && [key, histogram]: this->m_histograms) {
+        concerns[EventLogger::Concerns[key.first].name][key.second] = histogram->json();
+    }
+
+    QJsonObject result;
+    for (auto concern = concerns.cbegin(); concern != concerns.cend(); ++concern) {
+        result[concern.key()] = concern.value();
+    }
+    return result;
+}
+
+// Prometheus name: amos_<concern>_<name>, labels stay at the end
+QString Metrics::full_name(const Key & key) {
+    return QString("amos_%1_%2").arg(EventLogger::Concerns[key.first].name, key.second);
+}
+
+/**
+ * @brief Metrics::text
+ * Snapshot in the Prometheus text exposition format
+ */
+QString Metrics::text(void) const {
+    QMutexLocker lock(&this->m_mutex);
+    QString result;
+    QTextStream out(&result);
+    QString family;
+
+    auto type = [&out, &family](const QString & name, const char * kind) {
+        const QString base = name.section('{', 0, 0);
+        if (base != family) {
+            out << "# TYPE " << base << ' ' << kind << '\n';
+            family = base;
+        }
+    };
+
+    for (auto && [key, counter]: this->m_counters) {
+        const QString name = Metrics::full_name(key);
+        type(name, "counter");
+        out << name << ' ' << counter->value() << '\n';
+    }
+    for (auto && [key, gauge]: this->m_gauges) {
+        const QString name = Metrics::full_name(key);
+        type(name, "gauge");
+        out << name << ' ' << gauge->value() << '\n';
+    }
+    for (auto && [key, histogram]: this->m_histograms) {
+        const QString name = Metrics::full_name(key);
+        type(name, "histogram");
+        const std::vector<double> & bounds = histogram->bounds();
+        for (std::size_t i = 0; i < bounds.size(); ++i) {
+            out << name << "_bucket{le=\"" << bounds[i] << "\"} " << histogram->cumulative(i) << '\n';
+        }
+        out << name << "_bucket{le=\"+Inf\"} " << histogram->cumulative(bounds.size()) << '\n';
+        out << name << "_sum " << histogram->sum() << '\n';
+        out << name << "_count " << histogram->count() << '\n';
+    }
+    out.flush();
+    return result;
+}
+
+// Replaces the file atomically, so that a collector never reads a half-written snapshot
+bool Metrics::write_text(const QString & path) const {
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    file.write(this->text().toUtf8());
+    return file.commit();
+}
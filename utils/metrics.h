@@ -0,0 +1,82 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
+#include <QMutex>
+#include <QString>
+#include <QJsonObject>
+
+#include "logging/eventlogger.h"
+
+/**
+ * @brief The Metrics class is a registry of counters, gauges and fixed-bucket histograms grouped by Concern.
+ *        Looking a metric up takes a lock, updating it does not: call sites look it up once and keep the reference,
+ *        e.g. `static Metrics::Counter & sent = metrics.counter(Concern::Server, "heartbeats_sent");`.
+ *        Counter and gauge names may carry Prometheus labels, e.g. `available_bytes{storage="allsky-primary"}`.
+ *        Metrics are never removed, so the references stay valid for the lifetime of the registry.
+ */
+class Metrics {
+public:
+    class Counter {
+    private:
+        std::atomic<quint64> m_value = 0;
+    public:
+        inline void increment(quint64 by = 1) { this->m_value.fetch_add(by, std::memory_order_relaxed); }
+        inline quint64 value(void) const { return this->m_value.load(std::memory_order_relaxed); }
+    };
+
+    class Gauge {
+    private:
+        std::atomic<double> m_value = 0;
+    public:
+        inline void set(double value) { this->m_value.store(value, std::memory_order_relaxed); }
+        inline void add(double value) { this->m_value.fetch_add(value, std::memory_order_relaxed); }
+        inline double value(void) const { return this->m_value.load(std::memory_order_relaxed); }
+    };
+
+    // Cumulative buckets are only computed for the snapshot, an observation increments exactly one bucket
+    class Histogram {
+    private:
+        std::vector<double> m_bounds;
+        std::unique_ptr<std::atomic<quint64>[]> m_buckets;      // One per upper bound, plus one for +Inf
+        std::atomic<quint64> m_count = 0;
+        std::atomic<double> m_sum = 0;
+    public:
+        explicit Histogram(const std::vector<double> & bounds);
+
+        void observe(double value);
+        inline quint64 count(void) const { return this->m_count.load(std::memory_order_relaxed); }
+        inline double sum(void) const { return this->m_sum.load(std::memory_order_relaxed); }
+        inline const std::vector<double> & bounds(void) const { return this->m_bounds; }
+        quint64 cumulative(std::size_t bucket) const;
+
+        QJsonObject json(void) const;
+    };
+
+private:
+    typedef std::pair<Concern, QString> Key;
+
+    mutable QMutex m_mutex;
+    std::map<Key, std::unique_ptr<Counter>> m_counters;
+    std::map<Key, std::unique_ptr<Gauge>> m_gauges;
+    std::map<Key, std::unique_ptr<Histogram>> m_histograms;
+
+    static QString full_name(const Key & key);
+
+public:
+    // Default bucket bounds for durations, in seconds
+    inline const static std::vector<double> DurationBounds = {0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5, 10, 60};
+
+    Counter & counter(Concern concern, const QString & name);
+    Gauge & gauge(Concern concern, const QString & name);
+    Histogram & histogram(Concern concern, const QString & name, const std::vector<double> & bounds = Metrics::DurationBounds);
+
+    QJsonObject json(void) const;
+    QString text(void) const;
+    bool write_text(const QString & path) const;
+};
+
+#endif // METRICS_H
@@ -0,0 +1,98 @@
+#include <QTimer>
+
+#include "utils/qmetricsserver.h"
+#include "utils/metrics.h"
+
+extern Metrics metrics;
+
+
+QMetricsServer::QMetricsServer(QObject * parent):
+    QObject(parent),
+    // A child, so that it follows the worker to its thread
+    m_server(new QTcpServer(this))
+{
+    this->connect(this->m_server, &QTcpServer::newConnection, this, &QMetricsServer::accept);
+}
+
+void QMetricsServer::listen(const QHostAddress & address, quint16 port) {
+    this->stop();
+
+    if (!address.isLoopback()) {
+        emit this->log(Concern::Operation, Level::Warning,
+                       QString("Metrics endpoint is bound to %1, it is reachable from the network").arg(address.toString()));
+    }
+
+    if (this->m_server->listen(address, port)) {
+        emit this->log(Concern::Operation, Level::Info,
+                       QString("Metrics endpoint listening on http://%1:%2/metrics").arg(address.toString()).arg(port));
+    } else {
+        emit this->log(Concern::Operation, Level::Error,
+                       QString("Could not listen on %1:%2: %3").arg(address.toString()).arg(port).arg(this->m_server->errorString()));
+    }
+}
+
+void QMetricsServer::stop(void) {
+    if (this->m_server->isListening()) {
+        this->m_server->close();
+        emit this->log(Concern::Operation, Level::Info, "Metrics endpoint closed");
+    }
+}
+
+void QMetricsServer::accept(void) {
+    while (QTcpSocket * socket = this->m_server->nextPendingConnection()) {
+        this->connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { this->read_request(socket); });
+        this->connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        QTimer::singleShot(QMetricsServer::RequestTimeout, socket, &QTcpSocket::abort);
+    }
+}
+
+/**
+ * @brief QMetricsServer::read_request
+ * Waits until the request head is complete, then answers it. Only GET and HEAD of /metrics are served,
+ * headers are ignored and any body is never read.
+ */
+void QMetricsServer::read_request(QTcpSocket * socket) {
+    const QByteArray buffer = socket->peek(QMetricsServer::MaxRequestSize);
+    if (!buffer.contains("\r\n\r\n") && !buffer.contains("\n\n")) {
+        if (buffer.size() >= QMetricsServer::MaxRequestSize) {
+            this->respond(socket, "431 Request Header Fields Too Large", "Request too large\n");
+        }
+        return;
+    }
+
+    const QList<QByteArray> request = socket->readLine(QMetricsServer::MaxRequestSize).trimmed().split(' ');
+    if ((request.count() != 3) || !request[2].startsWith("HTTP/")) {
+        this->respond(socket, "400 Bad Request", "Bad request\n");
+        return;
+    }
+
+    const QByteArray & method = request[0];
+    const QByteArray path = request[1].section('?', 0, 0);
+    if ((method != "GET") && (method != "HEAD")) {
+        this->respond(socket, "405 Method Not Allowed", "Only GET and HEAD are supported\n");
+    } else if (path == "/metrics") {
+        static Metrics::Counter & scrapes = metrics.counter(Concern::Operation, "metrics_scrapes");
+        scrapes.increment();
+        this->respond(socket, "200 OK", metrics.text().toUtf8(), method == "HEAD", "text/plain; version=0.0.4; charset=utf-8");
+    } else {
+        this->respond(socket, "404 Not Found", "Metrics are served at /metrics\n", method == "HEAD");
+    }
+}
+
+void QMetricsServer::respond(QTcpSocket * socket, const QByteArray & status, const QByteArray & body, bool head,
+                             const QByteArray & content_type) {
+    // Exactly one response per connection
+    socket->disconnect(this);
+
+    QByteArray response = "HTTP/1.1 " + status + "\r\n"
+                          "Content-Type: " + content_type + "\r\n"
+                          "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                          "Cache-Control: no-store\r\n"
+                          "Connection: close\r\n\r\n";
+    if (!head) {
+        response += body;
+    }
+    socket->write(response);
+    // Closes only after the pending data are written
+    socket->disconnectFromHost();
+}
@@ -0,0 +1,47 @@
+#ifndef QMETRICSSERVER_H
+#define QMETRICSSERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+
+#include "logging/eventlogger.h"
+
+/**
+ * @brief The QMetricsServer class is a minimal HTTP listener that serves the metrics registry
+ *        in the Prometheus text format at /metrics, so that local scrapers can watch the station
+ *        at a higher resolution than the heartbeat without loading the central server.
+ *        It lives in its own thread and only reads the registry, the GUI thread is never involved.
+ *        Every connection answers a single request and is closed.
+ */
+class QMetricsServer: public QObject {
+    Q_OBJECT
+private:
+    QTcpServer * m_server;
+
+    constexpr static qint64 MaxRequestSize = 8192;          // Size in bytes: longest request head that is accepted
+    constexpr static int RequestTimeout = 5000;             // Time in ms: drop clients that do not finish their request
+
+    void read_request(QTcpSocket * socket);
+    void respond(QTcpSocket * socket, const QByteArray & status, const QByteArray & body, bool head = false,
+                 const QByteArray & content_type = "text/plain; charset=utf-8");
+
+private slots:
+    void accept(void);
+
+public:
+    constexpr static char DefaultAddress[] = "127.0.0.1";
+    constexpr static quint16 DefaultPort = 9180;
+
+    explicit QMetricsServer(QObject * parent = nullptr);
+
+public slots:
+    void listen(const QHostAddress & address, quint16 port);
+    void stop(void);
+
+signals:
+    void log(Concern concern, Level level, const QString & message);
+};
+
+#endif // QMETRICSSERVER_H
@@ -1,18 +1,94 @@
+#include <cstring>
+
 #include "utils/qserialbuffer.h"
 
 
 QSerialBuffer::QSerialBuffer(QObject * parent):
     QObject(parent),
-    m_data(QByteArray())
+    m_length(0),
+    m_frames(0),
+    m_resyncs(0),
+    m_oversize(0),
+    m_garbage(0)
 {}
 
-void QSerialBuffer::insert(const QByteArray & bytes) {
-    for (char b: bytes) {
-        this->m_data.append(b);
+// Find the first start byte in [begin, end), or end if there is none
+const char * QSerialBuffer::find_start(const char * begin, const char * end) {
+    const char * result = end;
+    for (const unsigned char start: {Telegram::StartByteSlave, Telegram::StartByteMaster}) {
+        const void * found = std::memchr(begin, start, result - begin);
+        if (found != nullptr) {
+            result = static_cast<const char *>(found);
+        }
+    }
+    return result;
+}
+
+// Find the first byte that ends the current frame (end byte or another start byte), or end if there is none
+const char * QSerialBuffer::find_boundary(const char * begin, const char * end) {
+    const char * result = end;
+    for (const unsigned char boundary: {Telegram::EndByte, Telegram::StartByteSlave, Telegram::StartByteMaster}) {
+        const void * found = std::memchr(begin, boundary, result - begin);
+        if (found != nullptr) {
+            result = static_cast<const char *>(found);
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief QSerialBuffer::insert processes a chunk of received bytes in bulk
+ */
+void QSerialBuffer::insert(QByteArrayView bytes) {
+    const char * position = bytes.data();
+    const char * const end = position + bytes.size();
+
+    while (position < end) {
+        if (this->m_length == 0) {
+            // Between frames: skip everything up to the next start byte
+            const char * start = QSerialBuffer::find_start(position, end);
+            if (start > position) {
+                this->m_garbage += start - position;
+                this->m_resyncs++;
+            }
+            if (start == end) {
+                return;
+            }
+            this->m_frame[0] = *start;
+            this->m_length = 1;
+            position = start + 1;
+        } else {
+            const char * boundary = QSerialBuffer::find_boundary(position, end);
+            const qsizetype chunk = boundary - position;
+            const bool terminated = (boundary < end) && (static_cast<unsigned char>(*boundary) == Telegram::EndByte);
+
+            if (this->m_length + chunk + (terminated ? 1 : 0) > Telegram::MaxLength) {
+                // Too long to be a telegram, drop it and look for the next start byte
+                this->m_oversize++;
+                this->m_garbage += this->m_length + chunk + (terminated ? 1 : 0);
+                this->m_length = 0;
+                position = terminated ? boundary + 1 : boundary;
+                continue;
+            }
+
+            std::memcpy(this->m_frame.data() + this->m_length, position, chunk);
+            this->m_length += chunk;
+            position = boundary;
+
+            if (position == end) {
+                return;
+            }
 
-        if (b == 0x0D) {
-            emit this->message_complete(this->m_data);
-            this->m_data.clear();
+            if (terminated) {
+                this->m_frame[this->m_length++] = *position++;
+                this->m_frames++;
+                emit this->frame_complete(QByteArrayView(this->m_frame.data(), this->m_length));
+            } else {
+                // Start byte inside a frame: the frame was cut off, start over from here
+                this->m_resyncs++;
+                this->m_garbage += this->m_length;
+            }
+            this->m_length = 0;
         }
     }
 }
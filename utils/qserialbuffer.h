@@ -1,19 +1,45 @@
 #ifndef QSERIALBUFFER_H
 #define QSERIALBUFFER_H
 
+#include <array>
 #include <QObject>
+#include <QByteArrayView>
 
+#include "utils/telegram.h"
+
+/**
+ * @brief The QSerialBuffer class cuts the incoming byte stream into telegrams.
+ *        A frame begins with a start byte and ends with the end byte, anything between frames is garbage.
+ *        Since the payload is hex-encoded, a start byte inside a frame means the previous frame was cut off
+ *        and the framer resynchronises. Frames are never longer than Telegram::MaxLength.
+ *        Complete frames are emitted as views into the internal buffer, valid only during the emission,
+ *        so `frame_complete` must be connected directly.
+ */
 class QSerialBuffer: public QObject {
     Q_OBJECT
 private:
-    QByteArray m_data;
+    std::array<char, Telegram::MaxLength> m_frame;
+    qsizetype m_length;
+
+    quint64 m_frames;
+    quint64 m_resyncs;
+    quint64 m_oversize;
+    quint64 m_garbage;
+
+    static const char * find_start(const char * begin, const char * end);
+    static const char * find_boundary(const char * begin, const char * end);
 
 public:
     QSerialBuffer(QObject * parent = nullptr);
-    void insert(const QByteArray & bytes);
+    void insert(QByteArrayView bytes);
+
+    inline quint64 frames(void) const { return this->m_frames; }
+    inline quint64 resyncs(void) const { return this->m_resyncs; }
+    inline quint64 oversize(void) const { return this->m_oversize; }
+    inline quint64 garbage(void) const { return this->m_garbage; }
 
 signals:
-    void message_complete(const QByteArray & message);
+    void frame_complete(QByteArrayView frame);
 };
 
 #endif // QSERIALBUFFER_H
@@ -1,11 +1,22 @@
+#include <algorithm>
 #include <QTimer>
 #include <QWaitCondition>
 
 #include "qserialportmanager.h"
 #include "logging/eventlogger.h"
 #include "utils/telegram.h"
+#include "utils/metrics.h"
 
 extern EventLogger logger;
+extern Metrics metrics;
+
+// Emit a log message only if the logger would write it, so that disabled messages are never formatted
+template<std::invocable Formatter>
+void QSerialPortManager::emit_log(Concern concern, Level level, Formatter && formatter) {
+    if (logger.is_active(level, concern)) {
+        emit this->log(concern, level, std::invoke(std::forward<Formatter>(formatter)));
+    }
+}
 
 
 const Request QSerialPortManager::RequestBasic        = Request('S', "basic data request");
@@ -16,6 +27,8 @@ const Request QSerialPortManager::RequestShaft        = Request('W', "shaft posi
 const Request QSerialPortManager::RequestShaft        = Request('Z', "shaft position request");
 #endif
 
+const Request QSerialPortManager::RequestCommand      = Request('C', "command");
+
 const SerialPortState QSerialPortManager::Disabled    = SerialPortState('D', "disabled", QColor(160, 160, 160));
 const SerialPortState QSerialPortManager::NotSet      = SerialPortState('N', "not set", QColor(96, 96, 96));
 const SerialPortState QSerialPortManager::Open        = SerialPortState('O', "connected", QColor(0, 192, 0));
@@ -26,7 +39,14 @@ QSerialPortManager::QSerialPortManager(QObject * parent):
     QObject(parent),
     m_enabled(false),
     m_request_timer(nullptr),
-    m_port(nullptr)
+    m_statistics_timer(nullptr),
+    m_port(nullptr),
+    m_polls({{
+        {&QSerialPortManager::RequestBasic, QSerialPortManager::IntervalBasic, -1, false, false, 0, 0, Histogram()},
+        {&QSerialPortManager::RequestShaft, QSerialPortManager::IntervalShaftIdle, -1, false, false, 0, 0, Histogram()},
+        {&QSerialPortManager::RequestEnv, QSerialPortManager::IntervalEnv, -1, false, false, 0, 0, Histogram()},
+    }}),
+    m_command({&QSerialPortManager::RequestCommand, 0, -1, false, false, 0, 0, Histogram()})
 {
     this->m_port = new QSerialPort(this);
     this->m_port->setBaudRate(QSerialPort::Baud9600);
@@ -34,7 +54,7 @@ QSerialPortManager::QSerialPortManager(QObject * parent):
     this->m_port->setPortName("");
     this->m_buffer = new QSerialBuffer(this);
 
-    this->connect(this->m_buffer, &QSerialBuffer::message_complete, this, &QSerialPortManager::message_complete);
+    this->connect(this->m_buffer, &QSerialBuffer::frame_complete, this, &QSerialPortManager::process_frame, Qt::DirectConnection);
 }
 
 QSerialPortManager::~QSerialPortManager(void) {
@@ -44,9 +64,15 @@ QSerialPortManager::~QSerialPortManager(void) {
 }
 
 void QSerialPortManager::initialize(void) {
+    this->m_clock.start();
     this->m_request_timer = new QTimer(this);
-    this->m_request_timer->setInterval(250);
+    this->m_request_timer->setInterval(QSerialPortManager::TickInterval);
     this->connect(this->m_request_timer, &QTimer::timeout, this, &QSerialPortManager::request_status);
+
+    this->m_statistics_timer = new QTimer(this);
+    this->m_statistics_timer->setInterval(QSerialPortManager::StatisticsInterval);
+    this->connect(this->m_statistics_timer, &QTimer::timeout, this, &QSerialPortManager::publish_statistics);
+    this->m_statistics_timer->start();
     emit this->log(Concern::SerialPort, Level::Info, "Dome thread initialized");
 }
 
@@ -92,20 +118,128 @@ void QSerialPortManager::reset(void) {
 
 }
 
+/**
+ * @brief QSerialPortManager::request_status
+ * Adaptive polling scheduler: every request type has its own interval, the shaft position is
+ * polled fast only while the servo is moving. Due requests are sent in order of priority (S, Z, T),
+ * up to PipelineDepth of them (queued commands included) may be waiting for a response at the same time.
+ */
 void QSerialPortManager::request_status(void) {
-    static QVector<Request> requests = {RequestBasic, RequestEnv, RequestShaft};
+    this->expire_requests();
+
+    const qint64 now = this->m_clock.elapsed();
+    int outstanding = std::count_if(this->m_polls.cbegin(), this->m_polls.cend(), [](const Poll & poll) { return poll.outstanding; }) +
+                      (this->m_command.outstanding ? 1 : 0);
 
-    this->request(requests[this->m_robin].for_telegram());
+    if (!this->m_commands.isEmpty() && !this->m_command.outstanding && (outstanding < QSerialPortManager::PipelineDepth)) {
+        this->request(this->m_commands.dequeue());
+        this->m_command.sent_at = now;
+        this->m_command.sent_ns = this->m_clock.nsecsElapsed();
+        if (this->m_port->isOpen()) {
+            this->m_command.outstanding = true;
+            outstanding++;
+        }
+    }
+
+    for (Poll & poll: this->m_polls) {
+        if (outstanding >= QSerialPortManager::PipelineDepth) {
+            break;
+        }
+        if (poll.outstanding || ((poll.sent_at >= 0) && (now - poll.sent_at < poll.interval))) {
+            continue;
+        }
 
-    this->m_robin = (this->m_robin + 1) % 3;
+        this->request(poll.request->for_telegram());
+        poll.sent_at = now;
+        poll.sent_ns = this->m_clock.nsecsElapsed();
+        if (this->m_port->isOpen()) {
+            poll.outstanding = true;
+            outstanding++;
+        }
+    }
+}
+
+// Forget requests that were not answered in time, so that they can be sent again
+void QSerialPortManager::expire_requests(void) {
+    const qint64 now = this->m_clock.elapsed();
+    for (Poll * channel: this->channels()) {
+        Poll & poll = *channel;
+        if (poll.outstanding && (now - poll.sent_at > QSerialPortManager::ResponseTimeout)) {
+            static Metrics::Counter & timeouts = metrics.counter(Concern::SerialPort, "response_timeouts");
+            poll.outstanding = false;
+            poll.expired = true;
+            poll.timeouts++;
+            timeouts.increment();
+            this->emit_log(Concern::SerialPort, Level::Debug, [&poll] {
+                return QString("No response to %1 within %2 ms (%3 timeouts so far)")
+                    .arg(poll.request->display_name()).arg(QSerialPortManager::ResponseTimeout).arg(poll.timeouts);
+            });
+        }
+    }
+}
+
+// Everything that can be waiting for a response: the polls and the command
+std::array<QSerialPortManager::Poll *, 4> QSerialPortManager::channels(void) {
+    return {&this->m_polls[0], &this->m_polls[1], &this->m_polls[2], &this->m_command};
+}
+
+QSerialPortManager::Poll * QSerialPortManager::find_poll(char code) {
+    for (Poll * channel: this->channels()) {
+        if (channel->request->code() == static_cast<unsigned char>(code)) {
+            return channel;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief QSerialPortManager::publish_statistics
+ * Snapshot of round-trip latencies (in ms, since start) and timeouts for every request type,
+ * keyed by the response code
+ */
+void QSerialPortManager::publish_statistics(void) {
+    QJsonObject statistics;
+    for (const Poll * channel: this->channels()) {
+        const Poll & poll = *channel;
+        QJsonObject entry = poll.latency.json(1000.0);
+        entry["to"] = static_cast<qint64>(poll.timeouts);
+        statistics[QString(QChar(poll.request->code())).toLower()] = entry;
+    }
+    emit this->statistics_updated(statistics);
+}
+
+void QSerialPortManager::set_servo_moving(bool moving) {
+    if (moving != this->m_servo_moving) {
+        this->m_servo_moving = moving;
+        Poll * shaft = this->find_poll(QSerialPortManager::RequestShaft.code());
+        shaft->interval = moving ? QSerialPortManager::IntervalShaftMoving : QSerialPortManager::IntervalShaftIdle;
+        this->emit_log(Concern::SerialPort, Level::Debug, [moving, shaft] {
+            return QString("Servo %1, polling shaft position every %2 ms").arg(moving ? "moving" : "stopped").arg(shaft->interval);
+        });
+    }
+}
+
+// Commands wait for a free place in the pipeline, usually there is one and the command is sent right away
+void QSerialPortManager::send_command(const QByteArray & command) {
+    this->m_commands.enqueue(command);
+    this->request_status();
 }
 
 void QSerialPortManager::request(const QByteArray & request) {
-    QByteArray encoded = Telegram(QSerialPortManager::Address, request).compose();
-    emit this->log(Concern::SerialPort, Level::DebugDetail, QString("Requesting %1 (%2)").arg(request, QString(encoded)));
+    char encoded[Telegram::MaxLength];
+    const qsizetype length = Telegram::encode(QSerialPortManager::Address, request, encoded, Telegram::MaxLength);
+    if (length < 0) {
+        emit this->log(Concern::SerialPort, Level::Error, QString("Request '%1' is too long to encode").arg(request));
+        return;
+    }
+    this->emit_log(Concern::SerialPort, Level::DebugDetail, [&] {
+        return QString("Requesting %1 (%2)").arg(request, QString::fromLatin1(encoded, length));
+    });
 
     if (this->m_port->isOpen()) {
-        this->m_port->write(encoded);
+        static Metrics::Counter & sent = metrics.counter(Concern::SerialPort, "requests_sent");
+        this->m_port->write(encoded, length);
+        sent.increment();
     } else {
         if (this->m_port->portName() == "") {
             emit this->port_state_changed(QSerialPortManager::NotSet);
@@ -119,14 +253,54 @@ void QSerialPortManager::process_response(void) {
     this->m_last_received = QDateTime::currentDateTimeUtc();
     this->m_error_counter = 0;
 
-    QByteArray response;
     while (this->m_port->bytesAvailable()) {
-        response += this->m_port->readAll();
+        this->m_buffer->insert(this->m_port->readAll());
+    }
+
+    if ((this->m_buffer->resyncs() != this->m_last_resyncs) || (this->m_buffer->oversize() != this->m_last_oversize)) {
+        static Metrics::Counter & resyncs = metrics.counter(Concern::SerialPort, "frames_resynchronised");
+        resyncs.increment((this->m_buffer->resyncs() - this->m_last_resyncs) + (this->m_buffer->oversize() - this->m_last_oversize));
+        emit this->log(Concern::SerialPort, Level::Warning,
+                       QString("Serial buffer resynchronised: %1 resyncs, %2 oversize frames, %3 bytes of garbage dropped so far")
+                           .arg(this->m_buffer->resyncs()).arg(this->m_buffer->oversize()).arg(this->m_buffer->garbage()));
+        this->m_last_resyncs = this->m_buffer->resyncs();
+        this->m_last_oversize = this->m_buffer->oversize();
     }
-    this->m_buffer->insert(response);
     emit this->port_state_changed(QSerialPortManager::Open);
 }
 
+// The frame is a view into the buffer, it has to be copied before crossing to the GUI thread
+void QSerialPortManager::process_frame(QByteArrayView frame) {
+    static Metrics::Counter & received = metrics.counter(Concern::SerialPort, "telegrams_received");
+    static Metrics::Counter & malformed = metrics.counter(Concern::SerialPort, "telegrams_malformed");
+    static Metrics::Counter & late = metrics.counter(Concern::SerialPort, "responses_late");
+    static Metrics::Histogram & response = metrics.histogram(Concern::SerialPort, "response_seconds",
+                                                             {0.01, 0.02, 0.05, 0.1, 0.2, 0.4, 1});
+    received.increment();
+
+    // Peek at the response type to mark the matching request as answered. Responses carry no sequence number:
+    // after a timeout the next response of that type may answer the expired request rather than the new one,
+    // so it only clears the request and is not timed, or it would be recorded as a bogus short round trip
+    Telegram::Frame decoded{};
+    if ((Telegram::decode(frame, decoded) == Telegram::Error::None) && (decoded.length > 0)) {
+        Poll * poll = this->find_poll(decoded.payload[0]);
+        if ((poll != nullptr) && poll->expired) {
+            poll->expired = false;
+            poll->outstanding = false;
+            late.increment();
+        } else if ((poll != nullptr) && poll->outstanding) {
+            const qint64 elapsed = (this->m_clock.nsecsElapsed() - poll->sent_ns) / 1000;
+            poll->outstanding = false;
+            poll->latency.record(elapsed);
+            response.observe(elapsed / 1e6);
+        }
+    } else {
+        malformed.increment();
+    }
+
+    emit this->message_complete(frame.toByteArray());
+}
+
 void QSerialPortManager::handle_error(QSerialPort::SerialPortError spe) {
     emit this->port_state_changed(QSerialPortManager::Error);
     emit this->error(this->m_port->portName(), spe, this->m_port->errorString());
@@ -1,12 +1,16 @@
 #ifndef QSERIALPORTMANAGER_H
 #define QSERIALPORTMANAGER_H
 
+#include <array>
 #include <QObject>
+#include <QQueue>
 #include <QThread>
 #include <QMutex>
 #include <QSerialPort>
+#include <QElapsedTimer>
 #include "qserialbuffer.h"
 #include "utils/request.h"
+#include "utils/histogram.h"
 #include "utils/state/serialportstate.h"
 
 #include "logging/eventlogger.h"
@@ -19,11 +23,29 @@ private:
     bool m_quit = false;
 
     QTimer * m_request_timer;
+    QTimer * m_statistics_timer;
     QSerialPort * m_port;
     QSerialBuffer * m_buffer;
 
-    QString m_response;
-    unsigned int m_robin = 0;
+    // One periodically polled request type
+    struct Poll {
+        const Request * request;
+        unsigned int interval;                              // Time in ms: how often to send it
+        qint64 sent_at;                                     // Time in ms since m_clock start, negative if never sent
+        bool outstanding;                                   // Sent and waiting for a response
+        bool expired;                                       // Timed out, the next response may be the late one and is not timed
+        quint64 timeouts;
+        qint64 sent_ns;                                     // Precise time of sending, for measuring latency
+        Histogram latency;                                  // Round-trip time in µs
+    };
+
+    QElapsedTimer m_clock;
+    std::array<Poll, 3> m_polls;
+    // Commands are answered with a 'C' state that does not say which command it belongs to,
+    // so they go out one at a time, ahead of the polls, and take a place in the pipeline like them
+    Poll m_command;
+    QQueue<QByteArray> m_commands;
+    bool m_servo_moving = false;
 
     QDateTime m_last_received;
     unsigned int m_error_counter = 0;
@@ -32,12 +54,32 @@ private:
     static constexpr unsigned int WriteTimeout = 200;
     static constexpr unsigned char Address = 0x99;
 
-    const static Request RequestBasic, RequestEnv, RequestShaft;
+    static constexpr unsigned int TickInterval = 50;            // Time in ms: how often the scheduler looks for due requests
+    static constexpr unsigned int IntervalBasic = 500;          // Time in ms: S state, automation depends on it
+    static constexpr unsigned int IntervalEnv = 1500;           // Time in ms: T state, changes slowly
+    static constexpr unsigned int IntervalShaftMoving = 250;    // Time in ms: Z state while the servo is moving
+    static constexpr unsigned int IntervalShaftIdle = 1500;     // Time in ms: Z state while the cover is parked
+    static constexpr unsigned int ResponseTimeout = 400;        // Time in ms: give up waiting for a response
+    static constexpr int PipelineDepth = 2;                     // Maximum number of requests waiting for a response
+    static constexpr unsigned int StatisticsInterval = 5000;    // Time in ms: how often to publish link statistics
+
+    const static Request RequestBasic, RequestEnv, RequestShaft, RequestCommand;
+
+    quint64 m_last_resyncs = 0;
+    quint64 m_last_oversize = 0;
 
     void clear_port(void);
+    void expire_requests(void);
+
+    template<std::invocable Formatter>
+    void emit_log(Concern concern, Level level, Formatter && formatter);
+    std::array<Poll *, 4> channels(void);
+    Poll * find_poll(char code);
 
 private slots:
+    void publish_statistics(void);
     void process_response(void);
+    void process_frame(QByteArrayView frame);
     void handle_error(QSerialPort::SerialPortError spe);
     void reset(void);
 
@@ -55,6 +97,8 @@ public:
 public slots:
     void set_enabled(bool enabled);
     void set_port(const QString & port_name);
+    void set_servo_moving(bool moving);
+    void send_command(const QByteArray & command);
 
 signals:
     void read_timeout(void);
@@ -64,6 +108,7 @@ signals:
     void port_state_changed(SerialPortState sps);
     void error(const QString & port_name, QSerialPort::SerialPortError spe, const QString & message);
     void message_complete(const QByteArray & message);
+    void statistics_updated(const QJsonObject & statistics);
 
     void log(Concern concern, Level level, const QString & message);
 };
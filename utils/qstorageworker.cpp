@@ -0,0 +1,244 @@
+#include <utility>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStorageInfo>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+
+#include "utils/qstorageworker.h"
+#include "utils/metrics.h"
+
+extern Metrics metrics;
+
+QStorageWorker::QStorageWorker(QObject * parent):
+    QObject(parent),
+    m_batch_timer(nullptr),
+    m_transfer_total(0),
+    m_transfer_done(0)
+{}
+
+void QStorageWorker::initialize(void) {
+    // Zero interval: everything queued during one pass of the event loop is processed as one batch
+    this->m_batch_timer = new QTimer(this);
+    this->m_batch_timer->setInterval(0);
+    this->m_batch_timer->setSingleShot(true);
+    this->connect(this->m_batch_timer, &QTimer::timeout, this, &QStorageWorker::process);
+    emit this->log(Concern::Storage, Level::Info, "Storage thread initialized");
+}
+
+void QStorageWorker::move_sighting(const QString & sighting_id, const QStringList & files, const QString & directory) {
+    this->m_moves[directory].append(Job{sighting_id, files});
+    this->m_batch_timer->start();
+}
+
+void QStorageWorker::remove_sighting(const QString & sighting_id, const QStringList & files) {
+    const QString directory = files.isEmpty() ? QString() : QFileInfo(files.first()).absolutePath();
+    this->m_deletions[directory].append(Job{sighting_id, files});
+    this->m_batch_timer->start();
+}
+
+// The directory may not exist yet, it will be created on the volume of its nearest existing ancestor
+bool QStorageWorker::is_same_volume(const QString & file, const QString & directory) {
+    QString target = QFileInfo(directory).absoluteFilePath();
+    while (!QFileInfo::exists(target)) {
+        const QString parent = QFileInfo(target).absolutePath();
+        if (parent == target) {
+            break;
+        }
+        target = parent;
+    }
+    return QStorageInfo(QFileInfo(file).absolutePath()).device() == QStorageInfo(target).device();
+}
+
+bool QStorageWorker::move_file(const QString & file, const QString & directory) {
+    const QString new_path = QString("%1/%2").arg(directory, QFileInfo(file).fileName());
+
+    if (!QStorageWorker::is_same_volume(file, directory)) {
+        return this->copy_file(file, new_path);
+    }
+
+    if (QFile::exists(new_path)) {
+        emit this->log(Concern::Storage, Level::Warning, QString("File '%1' already exists, deleting it first").arg(new_path));
+        QFile::remove(new_path);
+    }
+
+    if (QFile::rename(file, new_path)) {
+        emit this->log(Concern::Storage, Level::Debug, QString("Moved '%1' to '%2'").arg(file, new_path));
+        return true;
+    } else {
+        emit this->log(Concern::Storage, Level::Error, QString("Could not move file '%1' to '%2'").arg(file, new_path));
+        return false;
+    }
+}
+
+/**
+ * @brief QStorageWorker::copy_file
+ * Copies the file to another volume in large chunks. The copy is written to a temporary file
+ * that replaces the target only when complete, then it is read back and compared to the checksum
+ * of the source. The source is deleted only after a successful verification, so an interrupted
+ * copy never loses data.
+ */
+bool QStorageWorker::copy_file(const QString & file, const QString & new_path) {
+    QFile source(file);
+    if (!source.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        emit this->log(Concern::Storage, Level::Error, QString("Could not open '%1' for copying: %2").arg(file, source.errorString()));
+        return false;
+    }
+
+    QSaveFile target(new_path);
+    if (!target.open(QIODevice::WriteOnly | QIODevice::Unbuffered)) {
+        emit this->log(Concern::Storage, Level::Error, QString("Could not open '%1' for writing: %2").arg(new_path, target.errorString()));
+        return false;
+    }
+
+    static Metrics::Counter & copied = metrics.counter(Concern::Storage, "bytes_copied");
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    while (!source.atEnd()) {
+        const qint64 read = source.read(this->m_chunk.data(), QStorageWorker::ChunkSize);
+        if ((read < 0) || (target.write(this->m_chunk.constData(), read) != read)) {
+            emit this->log(Concern::Storage, Level::Error, QString("Could not copy '%1' to '%2': %3")
+                                                               .arg(file, new_path, read < 0 ? source.errorString() : target.errorString()));
+            target.cancelWriting();
+            return false;
+        }
+        hash.addData(QByteArrayView(this->m_chunk.constData(), read));
+        copied.increment(read);
+        this->m_transfer_done += read;
+        this->report_progress(false);
+    }
+    source.close();
+
+    if (!target.commit()) {
+        emit this->log(Concern::Storage, Level::Error, QString("Could not finish writing '%1': %2").arg(new_path, target.errorString()));
+        return false;
+    }
+
+    if (this->checksum(new_path) != hash.result()) {
+        emit this->log(Concern::Storage, Level::Error, QString("Checksum of '%1' does not match the source, keeping '%2'").arg(new_path, file));
+        QFile::remove(new_path);
+        return false;
+    }
+
+    emit this->log(Concern::Storage, Level::Debug, QString("Copied and verified '%1' to '%2'").arg(file, new_path));
+    return this->remove_file(file);
+}
+
+QByteArray QStorageWorker::checksum(const QString & file) {
+    QFile copy(file);
+    if (!copy.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        return QByteArray();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    while (!copy.atEnd()) {
+        const qint64 read = copy.read(this->m_chunk.data(), QStorageWorker::ChunkSize);
+        if (read < 0) {
+            return QByteArray();
+        }
+        hash.addData(QByteArrayView(this->m_chunk.constData(), read));
+    }
+    return hash.result();
+}
+
+// Throttled, so that a fast copy does not flood the GUI thread
+void QStorageWorker::report_progress(bool force) {
+    if (force || (this->m_report_clock.elapsed() >= QStorageWorker::ProgressInterval)) {
+        const double seconds = this->m_transfer_clock.elapsed() / 1000.0;
+        const double rate = (seconds > 0) ? this->m_transfer_done / seconds : 0;
+        emit this->transfer_progress(this->m_transfer_done, this->m_transfer_total, rate);
+        this->m_report_clock.restart();
+    }
+}
+
+bool QStorageWorker::remove_file(const QString & file) {
+    if (QFile::remove(file)) {
+        emit this->log(Concern::Storage, Level::Debug, QString("Deleted file '%1'").arg(file));
+        return true;
+    } else {
+        emit this->log(Concern::Storage, Level::Error, QString("Could not delete file '%1'").arg(file));
+        return false;
+    }
+}
+
+/**
+ * @brief QStorageWorker::process
+ * Processes all pending jobs, one directory at a time: the target directory
+ * is resolved and created only once per batch
+ */
+void QStorageWorker::process(void) {
+    const auto moves = std::exchange(this->m_moves, {});
+
+    // Find out how much has to be copied across volumes, to report progress and ETA
+    this->m_transfer_total = 0;
+    this->m_transfer_done = 0;
+    for (auto batch = moves.cbegin(); batch != moves.cend(); ++batch) {
+        for (const Job & job: batch.value()) {
+            for (const QString & file: job.files) {
+                if (!QStorageWorker::is_same_volume(file, batch.key())) {
+                    this->m_transfer_total += QFileInfo(file).size();
+                }
+            }
+        }
+    }
+    if (this->m_transfer_total > 0) {
+        this->m_chunk.resize(QStorageWorker::ChunkSize);
+        this->m_transfer_clock.start();
+        this->m_report_clock.start();
+        this->report_progress(true);
+    }
+
+    for (auto batch = moves.cbegin(); batch != moves.cend(); ++batch) {
+        const QString & directory = batch.key();
+        emit this->log(Concern::Storage, Level::Debug,
+                       QString("Moving %1 sightings to '%2'").arg(batch.value().count()).arg(directory));
+
+        if (!QDir().mkpath(directory)) {
+            emit this->log(Concern::Storage, Level::Error, QString("Could not create directory '%1'").arg(directory));
+            for (const Job & job: batch.value()) {
+                emit this->stored(job.sighting_id, false);
+            }
+            continue;
+        }
+
+        static Metrics::Histogram & duration = metrics.histogram(Concern::Storage, "move_seconds");
+        static Metrics::Counter & failed = metrics.counter(Concern::Storage, "moves_failed");
+        const QString canonical = QDir(directory).canonicalPath();
+        for (const Job & job: batch.value()) {
+            QElapsedTimer clock;
+            clock.start();
+            bool success = true;
+            for (const QString & file: job.files) {
+                success &= this->move_file(file, canonical);
+            }
+            duration.observe(clock.elapsed() / 1000.0);
+            if (!success) {
+                failed.increment();
+            }
+            emit this->stored(job.sighting_id, success);
+        }
+    }
+
+    if (this->m_transfer_total > 0) {
+        // Whatever was not copied has failed, report the transfer as finished anyway
+        this->m_transfer_done = this->m_transfer_total;
+        this->report_progress(true);
+        this->m_chunk.clear();
+        this->m_chunk.squeeze();
+    }
+
+    const auto deletions = std::exchange(this->m_deletions, {});
+    for (auto batch = deletions.cbegin(); batch != deletions.cend(); ++batch) {
+        emit this->log(Concern::Storage, Level::Debug,
+                       QString("Deleting %1 sightings from '%2'").arg(batch.value().count()).arg(batch.key()));
+
+        for (const Job & job: batch.value()) {
+            bool success = true;
+            for (const QString & file: job.files) {
+                success &= this->remove_file(file);
+            }
+            emit this->discarded(job.sighting_id, success);
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef QSTORAGEWORKER_H
+#define QSTORAGEWORKER_H
+
+#include <QObject>
+#include <QMap>
+#include <QTimer>
+#include <QStringList>
+#include <QElapsedTimer>
+
+#include "logging/eventlogger.h"
+
+/**
+ * @brief The QStorageWorker class moves and deletes sighting files in its own thread,
+ *        so that slow file operations (a rename across volumes is a full copy) do not block the GUI.
+ *        Requests are collected and processed in batches grouped by directory, completion is reported
+ *        by the `stored` and `discarded` signals.
+ *        Files that cross a volume boundary are copied in chunks, verified by a checksum
+ *        and only then deleted from the source; the progress is reported by `transfer_progress`.
+ */
+class QStorageWorker: public QObject {
+    Q_OBJECT
+private:
+    struct Job {
+        QString sighting_id;
+        QStringList files;
+    };
+
+    // Pending moves keyed by the target directory, pending deletions keyed by the source directory
+    QMap<QString, QVector<Job>> m_moves;
+    QMap<QString, QVector<Job>> m_deletions;
+    QTimer * m_batch_timer;
+
+    constexpr static qint64 ChunkSize = 4 << 20;            // Size in bytes of a single read/write of a cross-volume copy
+    constexpr static int ProgressInterval = 250;            // Time in ms: how often to report the progress of a copy
+
+    // Cross-volume transfer progress over the current batch
+    QByteArray m_chunk;
+    qint64 m_transfer_total;
+    qint64 m_transfer_done;
+    QElapsedTimer m_transfer_clock;
+    QElapsedTimer m_report_clock;
+
+    static bool is_same_volume(const QString & file, const QString & directory);
+    bool move_file(const QString & file, const QString & directory);
+    bool copy_file(const QString & file, const QString & new_path);
+    QByteArray checksum(const QString & file);
+    bool remove_file(const QString & file);
+    void report_progress(bool force);
+
+private slots:
+    void process(void);
+
+public:
+    explicit QStorageWorker(QObject * parent = nullptr);
+
+    void initialize(void);
+
+public slots:
+    void move_sighting(const QString & sighting_id, const QStringList & files, const QString & directory);
+    void remove_sighting(const QString & sighting_id, const QStringList & files);
+
+signals:
+    void stored(const QString & sighting_id, bool success);
+    void discarded(const QString & sighting_id, bool success);
+    void transfer_progress(qint64 done, qint64 total, double rate);
+
+    void log(Concern concern, Level level, const QString & message);
+};
+
+#endif // QSTORAGEWORKER_H
@@ -13,6 +13,7 @@ public:
     Request(unsigned char code, const QString & display_name);
     QByteArray for_telegram(void) const;
     const QString & display_name(void) const;
+    inline unsigned char code(void) const { return this->m_code; }
 };
 
 class Command: public Request {
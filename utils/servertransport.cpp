@@ -0,0 +1,183 @@
+#include <memory>
+#include <QElapsedTimer>
+
+#include "utils/servertransport.h"
+#include "utils/metrics.h"
+
+extern Metrics metrics;
+
+
+// Times in ns since the request was posted, -1 if the event did not happen
+struct ServerTransport::Timing {
+    QElapsedTimer clock;
+    qint64 connecting = -1;
+    qint64 connected = -1;
+    qint64 first_byte = -1;
+};
+
+ServerTransport::ServerTransport(QObject * parent):
+    QObject(parent),
+    m_manager(new QNetworkAccessManager(this)),
+    m_tls(false),
+    m_http2(Http2::Auto),
+    m_pipelining(false),
+    m_statistics_changed(false)
+{
+    this->connect(this->m_manager, &QNetworkAccessManager::finished, this, &ServerTransport::finished);
+
+    this->m_statistics_timer = new QTimer(this);
+    this->m_statistics_timer->setInterval(ServerTransport::StatisticsInterval);
+    this->connect(this->m_statistics_timer, &QTimer::timeout, this, &ServerTransport::publish_statistics);
+    this->m_statistics_timer->start();
+}
+
+void ServerTransport::configure(bool tls, Http2 http2, bool pipelining) {
+    this->m_tls = tls;
+    this->m_http2 = http2;
+    this->m_pipelining = pipelining;
+}
+
+ServerTransport::Http2 ServerTransport::parse_http2(const QString & mode) {
+    if (mode == "off") {
+        return Http2::Off;
+    } else if (mode == "upgrade") {
+        return Http2::Upgrade;
+    } else if (mode == "direct") {
+        return Http2::Direct;
+    } else {
+        return Http2::Auto;
+    }
+}
+
+QString ServerTransport::http2_name(Http2 mode) {
+    switch (mode) {
+        case Http2::Off:        return "off";
+        case Http2::Upgrade:    return "upgrade";
+        case Http2::Direct:     return "direct";
+        default:                return "auto";
+    }
+}
+
+void ServerTransport::apply(QNetworkRequest & request) const {
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, this->m_http2 != Http2::Off);
+    request.setAttribute(QNetworkRequest::Http2CleartextAllowedAttribute, this->m_http2 == Http2::Upgrade);
+    request.setAttribute(QNetworkRequest::Http2DirectAttribute, this->m_http2 == Http2::Direct);
+    request.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute, this->m_pipelining);
+}
+
+/**
+ * @brief ServerTransport::prewarm
+ * Opens a connection ahead of the first request, so that it does not pay for the lookup
+ * and the handshake. Not useful with h2c prior knowledge, which Qt cannot open in advance.
+ */
+void ServerTransport::prewarm(const QHostAddress & address, quint16 port) {
+    if (this->m_http2 == Http2::Direct) {
+        return;
+    }
+
+#if QT_CONFIG(ssl)
+    if (this->m_tls) {
+        this->m_manager->connectToHostEncrypted(address.toString(), port);
+        return;
+    }
+#endif
+    this->m_manager->connectToHost(address.toString(), port);
+}
+
+QNetworkReply * ServerTransport::post(QNetworkRequest request, const QByteArray & data, const QString & kind) {
+    this->apply(request);
+    QNetworkReply * reply = this->m_manager->post(request, data);
+    this->track(reply, kind);
+    return reply;
+}
+
+QNetworkReply * ServerTransport::post(QNetworkRequest request, QHttpMultiPart * multipart, const QString & kind) {
+    this->apply(request);
+    QNetworkReply * reply = this->m_manager->post(request, multipart);
+    this->track(reply, kind);
+    return reply;
+}
+
+/**
+ * @brief ServerTransport::track
+ * Follows the reply through its phases. The connection signals are only emitted
+ * when the request opens a new connection, a reused one skips them.
+ */
+void ServerTransport::track(QNetworkReply * reply, const QString & kind) {
+    auto timing = std::make_shared<Timing>();
+    timing->clock.start();
+
+    auto connected = [timing]() {
+        if (timing->connected < 0) {
+            timing->connected = timing->clock.nsecsElapsed();
+        }
+    };
+
+    this->connect(reply, &QNetworkReply::socketStartedConnecting, this, [timing]() {
+        timing->connecting = timing->clock.nsecsElapsed();
+    });
+#if QT_CONFIG(ssl)
+    this->connect(reply, &QNetworkReply::encrypted, this, connected);
+#endif
+    this->connect(reply, &QNetworkReply::uploadProgress, this, connected);
+    this->connect(reply, &QNetworkReply::requestSent, this, connected);
+    this->connect(reply, &QNetworkReply::metaDataChanged, this, [timing]() {
+        if (timing->first_byte < 0) {
+            timing->first_byte = timing->clock.nsecsElapsed();
+        }
+    });
+    this->connect(reply, &QNetworkReply::finished, this, [this, reply, kind, timing]() {
+        static Metrics::Counter & opened = metrics.counter(Concern::Server, "connections{reused=\"false\"}");
+        static Metrics::Counter & reused = metrics.counter(Concern::Server, "connections{reused=\"true\"}");
+
+        // Histograms are in µs, published in ms
+        Statistics & statistics = this->m_statistics[kind];
+        if (timing->connecting >= 0) {
+            statistics.opened++;
+            opened.increment();
+            statistics.dns.record(timing->connecting / 1000);
+            if (timing->connected >= timing->connecting) {
+                statistics.connect.record((timing->connected - timing->connecting) / 1000);
+            }
+        } else {
+            statistics.reused++;
+            reused.increment();
+        }
+        if (timing->first_byte >= 0) {
+            statistics.ttfb.record(timing->first_byte / 1000);
+        }
+        statistics.total.record(timing->clock.nsecsElapsed() / 1000);
+        if (reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool()) {
+            statistics.http2++;
+        }
+        if (reply->error() != QNetworkReply::NoError) {
+            statistics.failed++;
+        }
+        this->m_statistics_changed = true;
+    });
+}
+
+QJsonObject ServerTransport::json(void) const {
+    QJsonObject result;
+    for (auto item = this->m_statistics.cbegin(); item != this->m_statistics.cend(); ++item) {
+        const Statistics & statistics = item.value();
+        result[item.key()] = QJsonObject {
+            {"dns", statistics.dns.json(1000.0)},
+            {"connect", statistics.connect.json(1000.0)},
+            {"ttfb", statistics.ttfb.json(1000.0)},
+            {"total", statistics.total.json(1000.0)},
+            {"new", static_cast<qint64>(statistics.opened)},
+            {"reused", static_cast<qint64>(statistics.reused)},
+            {"h2", static_cast<qint64>(statistics.http2)},
+            {"err", static_cast<qint64>(statistics.failed)},
+        };
+    }
+    return result;
+}
+
+void ServerTransport::publish_statistics(void) {
+    if (this->m_statistics_changed) {
+        emit this->statistics_updated("Server requests [ms]", this->json());
+        this->m_statistics_changed = false;
+    }
+}
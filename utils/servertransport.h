@@ -0,0 +1,91 @@
+#ifndef SERVERTRANSPORT_H
+#define SERVERTRANSPORT_H
+
+#include <QObject>
+#include <QMap>
+#include <QTimer>
+#include <QHostAddress>
+#include <QHttpMultiPart>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QJsonObject>
+
+#include "utils/histogram.h"
+
+/**
+ * @brief The ServerTransport class is the single connection pool for all traffic to the AMOS server.
+ *        Heartbeats, backlog batches and sightings share one QNetworkAccessManager, so they reuse
+ *        the same keep-alive (or HTTP/2) connections instead of each paying for a new one.
+ *        Every request is timed; the phases are published as diagnostics per kind of request:
+ *          dns         from the request to the start of the connection, including queueing,
+ *                      since Qt does not report the end of the name lookup separately
+ *          connect     from the start of the connection until it is usable (TLS handshake done
+ *                      or first byte of the request written)
+ *          ttfb        from the request to the response headers
+ *          total       from the request to the end of the response
+ *        dns and connect are only recorded for requests that opened a new connection.
+ */
+class ServerTransport: public QObject {
+    Q_OBJECT
+public:
+    enum class Http2 {
+        Off,            // HTTP/1.1 only
+        Auto,           // HTTP/2 over TLS if the server offers it (ALPN), HTTP/1.1 otherwise
+        Upgrade,        // Also try to upgrade cleartext connections to h2c
+        Direct,         // h2c with prior knowledge, the server must speak HTTP/2 on the plain port
+    };
+
+private:
+    struct Timing;
+    struct Statistics {
+        Histogram dns;
+        Histogram connect;
+        Histogram ttfb;
+        Histogram total;
+        quint64 opened = 0;
+        quint64 reused = 0;
+        quint64 http2 = 0;
+        quint64 failed = 0;
+    };
+
+    QNetworkAccessManager * m_manager;
+    bool m_tls;
+    Http2 m_http2;
+    bool m_pipelining;
+
+    QMap<QString, Statistics> m_statistics;
+    QTimer * m_statistics_timer;
+    bool m_statistics_changed;
+
+    constexpr static int StatisticsInterval = 5000;         // Time in ms: how often the request timings are published
+
+    void apply(QNetworkRequest & request) const;
+    void track(QNetworkReply * reply, const QString & kind);
+
+private slots:
+    void publish_statistics(void);
+
+public:
+    explicit ServerTransport(QObject * parent = nullptr);
+
+    void configure(bool tls, Http2 http2, bool pipelining);
+    static Http2 parse_http2(const QString & mode);
+    static QString http2_name(Http2 mode);
+
+    inline bool is_tls(void) const { return this->m_tls; }
+    inline Http2 http2(void) const { return this->m_http2; }
+    inline bool is_pipelining(void) const { return this->m_pipelining; }
+    inline QString scheme(void) const { return this->m_tls ? "https" : "http"; }
+
+    void prewarm(const QHostAddress & address, quint16 port);
+    QNetworkReply * post(QNetworkRequest request, const QByteArray & data, const QString & kind);
+    QNetworkReply * post(QNetworkRequest request, QHttpMultiPart * multipart, const QString & kind);
+
+    QJsonObject json(void) const;
+
+signals:
+    void finished(QNetworkReply * reply);
+    void statistics_updated(const QString & section, const QJsonObject & statistics);
+};
+
+#endif // SERVERTRANSPORT_H
@@ -14,7 +14,8 @@ Sighting::Sighting(void):
     m_spectral(false),
     m_dir(QDir()),
     m_prefix(""),
-    m_status(Status::Unprocessed)
+    m_status(Status::Unprocessed),
+    m_attempts(0)
 {}
 
 Sighting::Sighting(const QDir & dir, const QString & prefix, bool spectral):
@@ -22,7 +23,8 @@ Sighting::Sighting(const QDir & dir, const QString & prefix, bool spectral):
     m_spectral(spectral),
     m_dir(dir),
     m_prefix(prefix),
-    m_status(Status::Unprocessed)
+    m_status(Status::Unprocessed),
+    m_attempts(0)
 {
     this->m_xml  = this->try_open( ".xml",  true);
     this->m_pjpg = this->try_open("P.jpg", false);
@@ -54,6 +56,17 @@ QVector<QString> Sighting::files(void) const {
     return {this->m_xml, this->m_pjpg, this->m_tjpg, this->m_mbmp, this->m_pbmp, this->m_avi};
 }
 
+// Only the files that were actually found
+QStringList Sighting::present_files(void) const {
+    QStringList present;
+    for (auto & file: this->files()) {
+        if (!file.isEmpty()) {
+            present.append(file);
+        }
+    }
+    return present;
+}
+
 QString Sighting::try_open(const QString & suffix, bool required) {
     QString full_path = QString("%1/%2%3").arg(this->m_dir.canonicalPath(), this->m_prefix, suffix);
     if (QFileInfo::exists(full_path)) {
@@ -107,45 +120,15 @@ void Sighting::set_status(Status new_status) {
                      .arg(this->status_string()));
 }
 
-bool Sighting::move(const QDir & dir) {
-    QDir().mkpath(dir.path());
-    logger.debug(Concern::Sightings, QString("Moving '%1' to '%2'").arg(this->prefix(), dir.canonicalPath()));
-
-    bool success = true;
-
-    for (auto & file: this->files()) {
-        if (file.isEmpty()) {
-            logger.debug(Concern::Sightings, QString("File '%1' not present in the sighting, skipping").arg(file));
-        } else {
-            QString new_path = QString("%1/%2").arg(dir.canonicalPath(), QFileInfo(file).fileName());
-
-            if (QFile::exists(new_path)) {
-                logger.warning(Concern::Sightings,
-                               QString("Could not move the sighting, deleting file '%3' first...")
-                                   .arg(new_path));
-                QFile::remove(new_path);
-            }
-
-            bool result = QFile::rename(file, new_path);
-            success &= result;
-
-            if (result) {
-                logger.debug(Concern::Sightings, QString("Moved '%3' to '%4'").arg(file, new_path));
-            } else {
-                logger.error(Concern::Sightings, QString("Could not move file '%3' to '%4'").arg(file, new_path));
-            }
-            file = new_path;
-        }
-    }
-    if (success) {
-        this->m_valid = false;
-        this->m_dir = dir;
-        this->undefer();
-        this->set_status(Status::Stored);
-    } else {
-        logger.error(Concern::Sightings, QString("Error when moving sighting '%1'").arg(this->prefix()));
-    }
-    return success;
+// Restore the state recorded in the journal by a previous run
+void Sighting::restore(Status status, const QDateTime & deferred_until, unsigned int attempts) {
+    this->m_status = status;
+    this->m_deferred_until = deferred_until;
+    this->m_attempts = attempts;
+    logger.debug(Concern::Sightings,
+                 QString("Restored '%1' as %2 after %3 attempts")
+                     .arg(this->prefix(), this->status_string())
+                     .arg(attempts));
 }
 
 void Sighting::defer(float seconds) {
@@ -165,54 +148,50 @@ double Sighting::deferred_for(void) const {
     }
 }
 
-void Sighting::discard() {
-    logger.warning(Concern::Sightings, QString("Discarding sighting '%1'").arg(this->prefix()));
-    try {
-        for (auto & file: this->files()) {
-            if (file.isEmpty()) {
-                logger.debug(Concern::Sightings, QString("File not present in the sighting"));
-            } else {
-                if (QFile::remove(file)) {
-                    logger.debug(Concern::Sightings, QString("Deleted file '%1'").arg(file));
-                } else {
-                    logger.error(Concern::Sightings, QString("Could not delete file '%1'").arg(file));
-                }
-            }
-        }
-        this->set_status(Status::Discarded);
-        this->undefer();
-    } catch (std::exception &) {
-        logger.error(Concern::Sightings, QString("Error while discarding sighting '%1'").arg(this->prefix()));
+/**
+ * @brief Sighting::open_body opens a file to be streamed as the body of a multipart upload.
+ *        The file is owned by the multipart and is read lazily while the request is being sent.
+ * @return the opened file or nullptr if it could not be opened
+ */
+QFile * Sighting::open_body(const QString & path, QHttpMultiPart * multipart) {
+    QFile * file = new QFile(path, multipart);
+    if (!file->open(QIODevice::ReadOnly)) {
+        logger.error(Concern::Sightings, QString("Could not open file '%1' for upload: %2").arg(path, file->errorString()));
+        delete file;
+        return nullptr;
     }
+    return file;
 }
 
-QHttpPart Sighting::jpg_part(void) const {
+QHttpPart Sighting::jpg_part(QHttpMultiPart * multipart) const {
     QHttpPart jpg_part;
-    if (this->m_xml == "") {
-        logger.error(Concern::Sightings, QString("XML file not present in sighting '%1'").arg(this->m_prefix));
+    if (this->m_pjpg == "") {
+        logger.error(Concern::Sightings, QString("JPG file not present in sighting '%1'").arg(this->m_prefix));
     } else {
         jpg_part.setHeader(QNetworkRequest::ContentTypeHeader, "image/jpeg");
         jpg_part.setHeader(
             QNetworkRequest::ContentDispositionHeader,
             QString("form-data; name=\"jpg\"; filename=\"%1\"").arg(QFileInfo(this->m_pjpg).fileName())
         );
-        QFile pjpg_file(this->m_pjpg);
-        pjpg_file.open(QIODevice::ReadOnly);
-        jpg_part.setBody(pjpg_file.readAll());
+        QFile * pjpg_file = Sighting::open_body(this->m_pjpg, multipart);
+        if (pjpg_file != nullptr) {
+            jpg_part.setBodyDevice(pjpg_file);
+        }
     }
     return jpg_part;
 }
 
-QHttpPart Sighting::xml_part(void) const {
+QHttpPart Sighting::xml_part(QHttpMultiPart * multipart) const {
     QHttpPart xml_part;
     xml_part.setHeader(QNetworkRequest::ContentTypeHeader, "application/xml; charset=utf-8");
     xml_part.setHeader(
         QNetworkRequest::ContentDispositionHeader,
         QString("form-data; name=\"xml\"; filename=\"%1\"").arg(QFileInfo(this->m_xml).fileName())
     );
-    QFile xml_file(this->m_xml);
-    xml_file.open(QIODevice::ReadOnly);
-    xml_part.setBody(xml_file.readAll());
+    QFile * xml_file = Sighting::open_body(this->m_xml, multipart);
+    if (xml_file != nullptr) {
+        xml_part.setBodyDevice(xml_file);
+    }
     return xml_part;
 }
 
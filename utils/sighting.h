@@ -34,8 +34,10 @@ private:
     QDateTime m_deferred_until;
     QUuid m_uuid;
     Status m_status;
+    unsigned int m_attempts;
 
     QString try_open(const QString & path, bool required);
+    static QFile * open_body(const QString & path, QHttpMultiPart * multipart);
 public:
     Sighting(void);
     Sighting(const QDir & dir, const QString & prefix, bool spectral);
@@ -43,6 +45,7 @@ public:
 
     inline QDir dir(void) const { return this->m_dir; }
     inline const QString & prefix(void) const { return this->m_prefix; }
+    inline const QUuid & uuid(void) const { return this->m_uuid; }
     inline QDateTime timestamp(void) const { return this->m_timestamp; }
     inline qint64 avi_size(void) const { return this->m_avi_size; }
     inline QString spectral_string(void) const { return this->is_spectral() ? "spectral" : "all-sky"; };
@@ -55,26 +58,32 @@ public:
     inline bool is_processed(void) const {
         return !(this->m_status == Status::Unprocessed || this->m_status == Status::Sent);
     }
+    // Still waiting for the server to accept or reject it
+    inline bool is_pending(void) const {
+        return !this->is_finished() && !(this->m_status == Status::Accepted || this->m_status == Status::Rejected);
+    }
+    inline unsigned int attempts(void) const { return this->m_attempts; }
+    inline void add_attempt(void) { this->m_attempts++; }
     inline QDateTime deferred_until(void) const { return this->m_deferred_until; }
     void set_status(Status new_status);
+    void restore(Status status, const QDateTime & deferred_until, unsigned int attempts);
 
     double deferred_for(void) const;
 
     inline Status status(void) const { return this->m_status; }
     QVector<QString> files(void) const;
+    QStringList present_files(void) const;
     QString str(void) const;
     QString status_string(void) const;
 
-    QHttpPart jpg_part(void) const;
-    QHttpPart xml_part(void) const;
+    QHttpPart jpg_part(QHttpMultiPart * multipart) const;
+    QHttpPart xml_part(QHttpMultiPart * multipart) const;
     QHttpPart json(void) const;
 
     void debug(void) const;
 
-    bool move(const QDir & dir);
     void defer(float seconds);
     void undefer(void);
-    void discard(void);
 
     bool hack_Y16(void) const;
 };
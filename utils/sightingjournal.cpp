@@ -0,0 +1,157 @@
+#include <QSaveFile>
+#include <QTextStream>
+
+#include "utils/sightingjournal.h"
+#include "logging/eventlogger.h"
+
+extern EventLogger logger;
+
+
+SightingJournal::SightingJournal(QObject * parent, const QString & filename):
+    QObject(parent),
+    m_filename(filename),
+    m_lines(0)
+{}
+
+SightingJournal::~SightingJournal(void) {
+    if (this->m_file != nullptr) {
+        this->m_file->close();
+        delete this->m_file;
+    }
+}
+
+void SightingJournal::initialize(void) {
+    this->load();
+    this->compact();
+}
+
+/**
+ * @brief SightingJournal::load
+ * Replays the journal, later lines override earlier ones. Malformed lines
+ * (typically a line cut short by a crash) are skipped.
+ */
+void SightingJournal::load(void) {
+    QFile file(this->m_filename);
+    if (!file.exists()) {
+        logger.info(Concern::Sightings, QString("Sighting journal '%1' does not exist, starting afresh").arg(this->m_filename));
+        return;
+    }
+
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        logger.error(Concern::Sightings, QString("Could not open sighting journal '%1': %2").arg(this->m_filename, file.errorString()));
+        return;
+    }
+
+    int malformed = 0;
+    QTextStream stream(&file);
+    while (!stream.atEnd()) {
+        QUuid uuid;
+        Entry entry;
+        if (SightingJournal::parse(stream.readLine(), uuid, entry)) {
+            this->m_entries.insert(uuid, entry);
+        } else {
+            malformed++;
+        }
+    }
+
+    logger.info(Concern::Sightings, QString("Sighting journal '%1' loaded, %2 entries").arg(this->m_filename).arg(this->m_entries.count()));
+    if (malformed > 0) {
+        logger.warning(Concern::Sightings, QString("Skipped %1 malformed lines in the sighting journal").arg(malformed));
+    }
+}
+
+void SightingJournal::open(void) {
+    this->m_file = new QFile(this->m_filename);
+    if (!this->m_file->open(QIODevice::Append | QIODevice::Text)) {
+        logger.error(Concern::Sightings, QString("Could not open sighting journal '%1' for writing: %2")
+                                             .arg(this->m_filename, this->m_file->errorString()));
+    }
+}
+
+QString SightingJournal::format(const QUuid & uuid, const Entry & entry) {
+    return QString("%1 %2 %3 %4 %5\n")
+        .arg(entry.updated.toString(Qt::ISODate))
+        .arg(uuid.toString(QUuid::WithoutBraces))
+        .arg(static_cast<int>(entry.status), 2, 16, QChar('0'))
+        .arg(entry.deferred_until.isValid() ? entry.deferred_until.toString(Qt::ISODate) : "-")
+        .arg(entry.attempts);
+}
+
+bool SightingJournal::parse(const QString & line, QUuid & uuid, Entry & entry) {
+    const QStringList fields = line.split(' ', Qt::SkipEmptyParts);
+    if (fields.count() != 5) {
+        return false;
+    }
+
+    bool ok_status, ok_attempts;
+    entry.updated = QDateTime::fromString(fields[0], Qt::ISODate);
+    uuid = QUuid::fromString(fields[1]);
+    entry.status = static_cast<Sighting::Status>(fields[2].toInt(&ok_status, 16));
+    entry.deferred_until = (fields[3] == "-") ? QDateTime() : QDateTime::fromString(fields[3], Qt::ISODate);
+    entry.attempts = fields[4].toUInt(&ok_attempts);
+
+    return entry.updated.isValid() && !uuid.isNull() && ok_status && ok_attempts;
+}
+
+const SightingJournal::Entry * SightingJournal::find(const QUuid & uuid) const {
+    auto item = this->m_entries.constFind(uuid);
+    return (item == this->m_entries.constEnd()) ? nullptr : &item.value();
+}
+
+void SightingJournal::record(const Sighting & sighting) {
+    Entry entry{sighting.status(), sighting.deferred_until(), sighting.attempts(), QDateTime::currentDateTimeUtc()};
+    this->m_entries.insert(sighting.uuid(), entry);
+
+    if (this->m_file == nullptr) {
+        this->open();
+    }
+    if (this->m_file->isOpen()) {
+        this->m_file->write(SightingJournal::format(sighting.uuid(), entry).toUtf8());
+        this->m_file->flush();
+        this->m_lines++;
+    }
+
+    if (this->m_lines > SightingJournal::CompactThreshold) {
+        this->compact();
+    }
+}
+
+/**
+ * @brief SightingJournal::compact
+ * Rewrites the journal atomically with only the latest entry for every sighting,
+ * dropping finished sightings older than the retention period
+ */
+void SightingJournal::compact(void) {
+    const QDateTime horizon = QDateTime::currentDateTimeUtc().addDays(-SightingJournal::Retention);
+    for (auto item = this->m_entries.begin(); item != this->m_entries.end();) {
+        const bool finished = (item->status == Sighting::Status::Stored) || (item->status == Sighting::Status::Discarded);
+        if (finished && (item->updated < horizon)) {
+            item = this->m_entries.erase(item);
+        } else {
+            ++item;
+        }
+    }
+
+    if (this->m_file != nullptr) {
+        this->m_file->close();
+        delete this->m_file;
+        this->m_file = nullptr;
+    }
+
+    QSaveFile file(this->m_filename);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        for (auto item = this->m_entries.cbegin(); item != this->m_entries.cend(); ++item) {
+            file.write(SightingJournal::format(item.key(), item.value()).toUtf8());
+        }
+        if (file.commit()) {
+            this->m_lines = this->m_entries.count();
+            logger.debug(Concern::Sightings, QString("Sighting journal compacted to %1 entries").arg(this->m_lines));
+        } else {
+            logger.error(Concern::Sightings, QString("Could not compact the sighting journal: %1").arg(file.errorString()));
+        }
+    } else {
+        logger.error(Concern::Sightings, QString("Could not compact the sighting journal: %1").arg(file.errorString()));
+    }
+
+    this->open();
+}
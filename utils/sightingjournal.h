@@ -0,0 +1,51 @@
+#include <QObject>
+#include <QFile>
+#include <QHash>
+#include <QUuid>
+#include <QDateTime>
+
+#include "utils/sighting.h"
+
+#ifndef SIGHTINGJOURNAL_H
+#define SIGHTINGJOURNAL_H
+
+/**
+ * @brief The SightingJournal class is an append-only record of status transitions of sightings,
+ *        keyed by their UUID. Every transition is appended as a single line, so a crash loses at most
+ *        the line being written. On start the journal is replayed and compacted to the latest entries.
+ */
+class SightingJournal: public QObject {
+    Q_OBJECT
+public:
+    struct Entry {
+        Sighting::Status status;
+        QDateTime deferred_until;
+        unsigned int attempts;
+        QDateTime updated;
+    };
+private:
+    constexpr static int CompactThreshold = 10000;          // Number of lines after which the journal is rewritten
+    constexpr static int Retention = 7;                     // Time in days: keep finished entries for this long
+
+    QString m_filename;
+    QFile * m_file = nullptr;
+    QHash<QUuid, Entry> m_entries;
+    int m_lines;
+
+    void load(void);
+    void open(void);
+    static QString format(const QUuid & uuid, const Entry & entry);
+    static bool parse(const QString & line, QUuid & uuid, Entry & entry);
+public:
+    explicit SightingJournal(QObject * parent, const QString & filename);
+    ~SightingJournal(void);
+
+    void initialize(void);
+    inline int count(void) const { return this->m_entries.count(); }
+    const Entry * find(const QUuid & uuid) const;
+
+    void record(const Sighting & sighting);
+    void compact(void);
+};
+
+#endif // SIGHTINGJOURNAL_H
@@ -1,29 +1,73 @@
 #ifndef TELEGRAM_H
 #define TELEGRAM_H
 
+#include <array>
 #include <QByteArray>
+#include <QByteArrayView>
 
 class Telegram {
-private:
-    unsigned char m_address;
-    QByteArray m_message;
-
+public:
     constexpr static unsigned char StartByteSlave = 0x5A;
     constexpr static unsigned char StartByteMaster = 0x55;
     constexpr static unsigned char EndByte = 0x0D;
     constexpr static unsigned char MaxLength = 100;
+    constexpr static unsigned char MaxPayload = (MaxLength - 8) / 2;
+
+    enum class Error {
+        None = 0,
+        Length,
+        ClaimedLength,
+        Encoding,
+        CRC,
+        StartByte,
+        EndByte,
+    };
 
-    static unsigned char char_to_hex(unsigned char value);
-    static unsigned char hex_to_char(unsigned char value);
-    static unsigned char encode_msq(unsigned char value);
-    static unsigned char encode_lsq(unsigned char value);
+    // Decoded telegram, lives on the stack, no allocation
+    struct Frame {
+        unsigned char address;
+        unsigned char length;
+        std::array<char, MaxPayload> payload;
 
-    static unsigned char decode_byte(unsigned char first, unsigned char second);
+        inline QByteArrayView message(void) const { return QByteArrayView(this->payload.data(), this->length); }
+    };
+
+private:
+    unsigned char m_address;
+    QByteArray m_message;
+
+    constexpr static signed char Invalid = -1;
+
+    // Nibble to character [0-9A-F]
+    constexpr static char EncodeTable[] = "0123456789ABCDEF";
+
+    // Character to nibble, Invalid for anything that is not [0-9A-F]
+    constexpr static std::array<signed char, 256> DecodeTable = [] {
+        std::array<signed char, 256> table{};
+        for (auto & entry: table) {
+            entry = Invalid;
+        }
+        for (int i = 0; i < 16; ++i) {
+            table[static_cast<unsigned char>(EncodeTable[i])] = static_cast<signed char>(i);
+        }
+        return table;
+    }();
+
+    // Decode a hexadecimal pair "AB" to the corresponding byte, negative on invalid characters
+    constexpr static int decode_byte(char first, char second) {
+        const int high = DecodeTable[static_cast<unsigned char>(first)];
+        const int low = DecodeTable[static_cast<unsigned char>(second)];
+        return ((high | low) < 0) ? -1 : ((high << 4) | low);
+    }
 
 public:
     Telegram(const unsigned char address, const QByteArray & message);
     Telegram(const QByteArray & message);
 
+    static Error decode(QByteArrayView received, Frame & frame);
+    static qsizetype encode(unsigned char address, QByteArrayView message, char * buffer, qsizetype capacity);
+    static const char * error_string(Error error);
+
     QByteArray compose(void) const;
     inline QByteArray get_message(void) const { return this->m_message; };
 };
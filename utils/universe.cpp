@@ -1,8 +1,87 @@
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <QTimeZone>
+
 #include "universe.h"
+#include "utils/ephemeriscache.h"
+
+extern EphemerisCache ephemeris;
+
+namespace {
+    // Pegasus only accepts a plain function, so the function being solved is passed on the side
+    struct CrossingProblem {
+        Universe::AltitudeFunction fun;
+        double latitude;
+        double longitude;
+        double altitude;
+
+        // Distance from the almucantar at `time`, in seconds since the epoch
+        inline double operator()(double time) const {
+            return this->fun(this->latitude, this->longitude,
+                             QDateTime::fromMSecsSinceEpoch(std::llround(time * 1000.0), QTimeZone::UTC)) - this->altitude;
+        }
+    };
+
+    thread_local const CrossingProblem * problem = nullptr;
+
+    double evaluate_problem(double time) {
+        return (*problem)(time);
+    }
+
+    /* Horizontal coordinates from equatorial vectors, the same as GMST and Equ2Hor do for a single instant.
+     * Written as a plain loop over arrays without calls into APC, so that the compiler can vectorise it. */
+    void equatorial_to_horizon(double latitude, double longitude, qsizetype count, const double * mjd,
+                               const double * ex, const double * ey, const double * ez,
+                               double * altitude, double * azimuth) {
+        const double sin_lat = std::sin(latitude * Rad);
+        const double cos_lat = std::cos(latitude * Rad);
+        constexpr double Secs = 86400.0;
+
+        for (qsizetype i = 0; i < count; ++i) {
+            const double mjd_0 = std::floor(mjd[i]);
+            const double ut = Secs * (mjd[i] - mjd_0);
+            const double t_0 = (mjd_0 - 51544.5) / 36525.0;
+            const double t = (mjd[i] - 51544.5) / 36525.0;
+            const double gmst = 24110.54841 + 8640184.812866 * t_0 + 1.0027379093 * ut + (0.093104 - 6.2e-6 * t) * t * t;
+            const double lmst = (pi2 / Secs) * (gmst - Secs * std::floor(gmst / Secs)) + longitude * Rad;
+            const double c = std::cos(lmst);
+            const double s = std::sin(lmst);
+
+            // Rotate by the hour angle, then tilt by the colatitude (R_y)
+            const double vx = c * ex[i] + s * ey[i];
+            const double vy = s * ex[i] - c * ey[i];
+            const double hx = sin_lat * vx - cos_lat * ez[i];
+            const double hz = cos_lat * vx + sin_lat * ez[i];
+
+            altitude[i] = std::atan2(hz, std::sqrt(hx * hx + vy * vy)) * Deg;
+            const double az = std::atan2(vy, hx) * Deg + 180.0;
+            azimuth[i] = (az >= 360.0) ? az - 360.0 : az;
+        }
+    }
+
+    Universe::HorizonTrack track(void (EphemerisCache::*equatorial)(const double *, qsizetype, double *, double *, double *) const,
+                                 double latitude, double longitude, double start, double step, qsizetype count) {
+        Universe::HorizonTrack result;
+        count = std::max<qsizetype>(count, 0);
+        result.mjd.resize(count);
+        result.altitude.resize(count);
+        result.azimuth.resize(count);
+        for (qsizetype i = 0; i < count; ++i) {
+            result.mjd[i] = start + i * step;
+        }
+
+        QVector<double> ex(count), ey(count), ez(count);
+        (ephemeris.*equatorial)(result.mjd.constData(), count, ex.data(), ey.data(), ez.data());
+        equatorial_to_horizon(latitude, longitude, count, result.mjd.constData(), ex.constData(), ey.constData(), ez.constData(),
+                              result.altitude.data(), result.azimuth.data());
+        return result;
+    }
+}
 
 // Compute modified Julian date for specified UTC time
 double Universe::mjd(const QDateTime & time) {
-    return 40587.0 + ((double) time.toSecsSinceEpoch()) / 86400.0;
+    return 40587.0 + ((double) time.toMSecsSinceEpoch()) / 86400000.0;
 }
 
 // Compute Julian centuries since J2000.0
@@ -15,16 +94,25 @@ Vec3D Universe::compute_sun_ecl(const QDateTime & time) {
     return SunPos(Universe::julian_centuries(time));
 }
 
-// Compute equatorial coordinates of the Sun
+// Compute equatorial coordinates of the Sun, from the ephemeris cache if possible
 Vec3D Universe::compute_sun_equ(const QDateTime & time) {
+    return ephemeris.sun_equ(Universe::mjd(time));
+}
+
+Vec3D Universe::compute_moon_equ(const QDateTime & time) {
+    return ephemeris.moon_equ(Universe::mjd(time));
+}
+
+// The same without the cache, for the cache to fit and check against
+Vec3D Universe::sun_equ_direct(double mjd) {
     double ra, dec;
-    MiniSun(Universe::julian_centuries(time), ra, dec);
+    MiniSun((mjd + Universe::delta_t - MJD_J2000) / 36525.0, ra, dec);
     return Vec3D(Polar(ra, dec));
 }
 
-Vec3D Universe::compute_moon_equ(const QDateTime & time) {
+Vec3D Universe::moon_equ_direct(double mjd) {
     double ra, dec;
-    MiniMoon(Universe::julian_centuries(time), ra, dec);
+    MiniMoon((mjd + Universe::delta_t - MJD_J2000) / 36525.0, ra, dec);
     return Vec3D(Polar(ra, dec));
 }
 
@@ -67,24 +155,89 @@ double Universe::moon_azimuth(const double latitude, const double longitude, con
     return fmod(Universe::moon_position(latitude, longitude, time).phi * Deg + 360.0, 360.0);
 }
 
-QDateTime Universe::next_crossing(std::function<double(double, double, QDateTime)> fun,
-                                  double latitude, double longitude, double altitude, bool direction_up, int resolution) {
-    QDateTime now = QDateTime::fromSecsSinceEpoch((QDateTime::currentDateTimeUtc().toSecsSinceEpoch() / resolution) * resolution);
-    double oldalt = fun(latitude, longitude, now);
+/**
+ * @brief Universe::sun_track
+ * Altitude and azimuth of the Sun at `count` instants from `start` (MJD) in steps of `step` days.
+ * Equivalent to calling sun_position for every instant, but without the QDateTime conversions,
+ * and with the coordinate transformation in a single vectorisable loop.
+ */
+Universe::HorizonTrack Universe::sun_track(double latitude, double longitude, double start, double step, qsizetype count) {
+    return track(&EphemerisCache::sun_equ, latitude, longitude, start, step, count);
+}
+
+// The same with the Moon
+Universe::HorizonTrack Universe::moon_track(double latitude, double longitude, double start, double step, qsizetype count) {
+    return track(&EphemerisCache::moon_equ, latitude, longitude, start, step, count);
+}
+
+/**
+ * @brief Universe::crossings
+ * Finds all crossings of the almucantar `altitude` by `fun` between `from` and `to`, in order.
+ * The window is covered by steps of 2 * CrossingStep. In every step a parabola is fitted through
+ * three samples with Quad, which tells whether the step contains zero, one or two crossings; two crossings
+ * without a sign change between the samples are separated at the extremum of the parabola.
+ * Every sign change is then refined with Pegasus to CrossingAccuracy.
+ * A day takes about 25 evaluations for the step plus 5 to 10 per crossing.
+ */
+QVector<Universe::Crossing> Universe::crossings(AltitudeFunction fun, double latitude, double longitude, double altitude,
+                                                 const QDateTime & from, const QDateTime & to) {
+    const CrossingProblem current{fun, latitude, longitude, altitude};
+    const CrossingProblem * const outer = problem;
+    problem = &current;
+
+    QVector<Crossing> result;
+    const double start = from.toMSecsSinceEpoch() / 1000.0;
+    const double end = to.toMSecsSinceEpoch() / 1000.0;
+    const double h = Universe::CrossingStep;
+
+    double y_minus = current(start);
+    for (double centre = start + h; centre - h < end; centre += 2 * h) {
+        const double y_0 = current(centre);
+        const double y_plus = current(centre + h);
+
+        double xe, ye, root1, root2;
+        int n_root;
+        Quad(y_minus, y_0, y_plus, xe, ye, root1, root2, n_root);
+
+        // Samples in units of h around the centre; a sign change between two of them brackets a crossing
+        QVector<std::pair<double, double>> samples = {{-1, y_minus}, {0, y_0}, {1, y_plus}};
+        const bool bracketed = ((y_minus < 0) != (y_0 < 0)) || ((y_0 < 0) != (y_plus < 0));
+        if ((n_root == 2) && !bracketed && (std::fabs(xe) < 1)) {
+            samples.insert(xe < 0 ? 1 : 2, {xe, current(centre + xe * h)});
+        }
 
-    for (int i = 1; i <= 86400 / resolution; ++i) {
-        QDateTime instant = now.addSecs(resolution * i);
-        double newalt = fun(latitude, longitude, instant);
-        if (direction_up) {
-            if ((oldalt < altitude) && (newalt > altitude)) {
-                return instant;
+        for (qsizetype i = 1; i < samples.count(); ++i) {
+            const auto & [x1, y1] = samples[i - 1];
+            const auto & [x2, y2] = samples[i];
+            if ((y1 < 0) == (y2 < 0)) {
+                continue;
             }
-        } else {
-            if ((oldalt > altitude) && (newalt < altitude)) {
-                return instant;
+
+            double root;
+            bool success;
+            Pegasus(evaluate_problem, centre + x1 * h, centre + x2 * h, Universe::CrossingAccuracy, root, success);
+            if (!success) {
+                // Did not converge, fall back to linear interpolation between the samples
+                root = centre + (x1 - y1 * (x2 - x1) / (y2 - y1)) * h;
+            }
+            if ((root >= start) && (root <= end)) {
+                result.append({QDateTime::fromMSecsSinceEpoch(std::llround(root * 1000.0), QTimeZone::UTC), y1 < 0});
             }
         }
-        oldalt = newalt;
+        y_minus = y_plus;
+    }
+
+    problem = outer;
+    return result;
+}
+
+// First crossing in the specified direction within the next 24 hours in local time, or an invalid QDateTime if there is none
+QDateTime Universe::next_crossing(AltitudeFunction fun, double latitude, double longitude, double altitude, bool direction_up) {
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    for (const Crossing & crossing: Universe::crossings(fun, latitude, longitude, altitude, now, now.addDays(1))) {
+        if (crossing.direction_up == direction_up) {
+            return crossing.time.toLocalTime();
+        }
     }
     return QDateTime();
 }
@@ -2,15 +2,35 @@
 #define UNIVERSE_H
 
 #include <QDateTime>
+#include <QVector>
 
 #include "APC\APC_include.h"
 
 namespace Universe {
     constexpr static double delta_t = 67.28 / 86400.0;
 
+    constexpr static int CrossingStep = 3600;               // Time in s: half-width of the windows in which crossings are bracketed
+    constexpr static double CrossingAccuracy = 0.1;         // Time in s: crossings are refined to this accuracy
+
+    typedef double (*AltitudeFunction)(const double latitude, const double longitude, const QDateTime & time);
+
+    struct Crossing {
+        QDateTime time;
+        bool direction_up;
+    };
+
+    // Horizontal coordinates at evenly spaced instants, as parallel arrays
+    struct HorizonTrack {
+        QVector<double> mjd;
+        QVector<double> altitude;           // Angle in degrees
+        QVector<double> azimuth;            // Angle in degrees, from the north
+    };
+
     Vec3D compute_sun_ecl(const QDateTime & time = QDateTime::currentDateTimeUtc());
     Vec3D compute_sun_equ(const QDateTime & time = QDateTime::currentDateTimeUtc());
     Vec3D compute_moon_equ(const QDateTime & time = QDateTime::currentDateTimeUtc());
+    Vec3D sun_equ_direct(double mjd);
+    Vec3D moon_equ_direct(double mjd);
 
     double mjd(const QDateTime & time = QDateTime::currentDateTimeUtc());
     double julian_centuries(const QDateTime & time = QDateTime::currentDateTimeUtc());
@@ -23,9 +43,12 @@ namespace Universe {
     double moon_altitude(const double latitude, const double longitude, const QDateTime & time = QDateTime::currentDateTimeUtc());
     double moon_azimuth(const double latitude, const double longitude, const QDateTime & time = QDateTime::currentDateTimeUtc());
 
-    QDateTime next_crossing(std::function<double(double, double, QDateTime)> fun,
-                            double latitude, double longitude, double altitude,
-                            bool direction_up, int resolution = 60);
+    HorizonTrack sun_track(double latitude, double longitude, double start, double step, qsizetype count);
+    HorizonTrack moon_track(double latitude, double longitude, double start, double step, qsizetype count);
+
+    QVector<Crossing> crossings(AltitudeFunction fun, double latitude, double longitude, double altitude,
+                                const QDateTime & from, const QDateTime & to);
+    QDateTime next_crossing(AltitudeFunction fun, double latitude, double longitude, double altitude, bool direction_up);
 };
 
 #endif // UNIVERSE_H
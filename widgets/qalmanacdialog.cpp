@@ -0,0 +1,157 @@
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QDialogButtonBox>
+#include <QFileDialog>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QThreadPool>
+#include <QPromise>
+
+#include "widgets/qalmanacdialog.h"
+#include "widgets/qstation.h"
+#include "logging/eventlogger.h"
+
+extern EventLogger logger;
+
+
+QAlmanacDialog::QAlmanacDialog(const QStation * station, QWidget * parent):
+    QDialog(parent),
+    m_station(station),
+    m_almanac(station->latitude(), station->longitude(), QCamera::DefaultDarknessLimit)
+{
+    this->setWindowTitle("Almanac");
+    this->resize(720, 600);
+
+    this->m_year = new QSpinBox(this);
+    this->m_year->setRange(1900, 2100);
+    this->m_year->setValue(QDate::currentDate().year());
+
+    this->m_camera = new QComboBox(this);
+    this->m_camera->addItem("All-sky camera");
+    this->m_camera->addItem("Spectral camera");
+
+    this->m_compute = new QPushButton("Compute", this);
+    this->m_export_csv = new QPushButton("Export CSV...", this);
+    this->m_export_json = new QPushButton("Export JSON...", this);
+    this->m_export_csv->setEnabled(false);
+    this->m_export_json->setEnabled(false);
+
+    this->m_summary = new QLabel(this);
+
+    this->m_table = new QTableWidget(0, 6, this);
+    this->m_table->setHorizontalHeaderLabels({"Date", "Dusk (UTC)", "Dawn (UTC)", "Dark [h]", "Moonless [h]", "Moon illumination"});
+    this->m_table->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    this->m_table->verticalHeader()->setVisible(false);
+    this->m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    this->m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+
+    QDialogButtonBox * buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+
+    QHBoxLayout * controls = new QHBoxLayout();
+    controls->addWidget(new QLabel("Year", this));
+    controls->addWidget(this->m_year);
+    controls->addWidget(this->m_camera);
+    controls->addWidget(this->m_compute);
+    controls->addStretch();
+    controls->addWidget(this->m_export_csv);
+    controls->addWidget(this->m_export_json);
+
+    QVBoxLayout * layout = new QVBoxLayout(this);
+    layout->addLayout(controls);
+    layout->addWidget(this->m_summary);
+    layout->addWidget(this->m_table);
+    layout->addWidget(buttons);
+
+    this->m_watcher = new QFutureWatcher<QVector<Almanac::Night>>(this);
+    this->connect(this->m_watcher, &QFutureWatcherBase::finished, this, &QAlmanacDialog::computed);
+    this->connect(this->m_compute, &QPushButton::clicked, this, &QAlmanacDialog::compute);
+    this->connect(this->m_export_csv, &QPushButton::clicked, this, &QAlmanacDialog::export_csv);
+    this->connect(this->m_export_json, &QPushButton::clicked, this, &QAlmanacDialog::export_json);
+    this->connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    this->compute();
+}
+
+void QAlmanacDialog::compute(void) {
+    const QCamera * camera = (this->m_camera->currentIndex() == 0) ? this->m_station->camera_allsky() : this->m_station->camera_spectral();
+    this->m_almanac = Almanac(this->m_station->latitude(), this->m_station->longitude(), camera->darkness_limit());
+
+    this->m_compute->setEnabled(false);
+    this->m_export_csv->setEnabled(false);
+    this->m_export_json->setEnabled(false);
+    this->m_summary->setText("Computing...");
+
+    // The task only holds copies, so the dialog may be closed before it finishes
+    auto promise = std::make_shared<QPromise<QVector<Almanac::Night>>>();
+    this->m_watcher->setFuture(promise->future());
+    this->m_elapsed.start();
+    QThreadPool::globalInstance()->start([promise, almanac = this->m_almanac, year = this->m_year->value()]() {
+        promise->start();
+        promise->addResult(almanac.compute_year(year));
+        promise->finish();
+    });
+}
+
+void QAlmanacDialog::computed(void) {
+    this->m_nights = this->m_watcher->result();
+    logger.debug(Concern::Operation, QString("Almanac for %1 computed in %2 ms").arg(this->m_year->value()).arg(this->m_elapsed.elapsed()));
+
+    this->display();
+    this->m_compute->setEnabled(true);
+    this->m_export_csv->setEnabled(true);
+    this->m_export_json->setEnabled(true);
+}
+
+void QAlmanacDialog::display(void) {
+    auto time = [](const QDateTime & instant) {
+        return instant.isValid() ? instant.toString("hh:mm") : "--:--";
+    };
+
+    this->m_table->setRowCount(this->m_nights.count());
+    for (qsizetype row = 0; row < this->m_nights.count(); ++row) {
+        const Almanac::Night & night = this->m_nights[row];
+        const QStringList cells = {
+            night.date.toString(Qt::ISODate),
+            time(night.dusk),
+            time(night.dawn),
+            QString::number(night.dark_hours, 'f', 2),
+            QString::number(night.moonless_hours, 'f', 2),
+            QString::number(night.moon_illumination, 'f', 3),
+        };
+        for (int column = 0; column < cells.count(); ++column) {
+            QTableWidgetItem * item = new QTableWidgetItem(cells[column]);
+            item->setTextAlignment(column == 0 ? Qt::AlignLeft | Qt::AlignVCenter : Qt::AlignRight | Qt::AlignVCenter);
+            this->m_table->setItem(row, column, item);
+        }
+    }
+
+    this->m_summary->setText(QString("Darkness limit %1°: %2 dark hours, %3 of them moonless (computed in %4 ms)")
+        .arg(this->m_almanac.darkness_limit(), 0, 'f', 1)
+        .arg(Almanac::dark_hours(this->m_nights), 0, 'f', 0)
+        .arg(Almanac::moonless_hours(this->m_nights), 0, 'f', 0)
+        .arg(this->m_elapsed.elapsed()));
+}
+
+void QAlmanacDialog::save(const QString & filter, const QByteArray & contents) {
+    const QString filename = QFileDialog::getSaveFileName(this, "Export almanac",
+                                                          QString("almanac-%1").arg(this->m_year->value()), filter);
+    if (filename.isEmpty()) {
+        return;
+    }
+
+    QSaveFile file(filename);
+    if (file.open(QIODevice::WriteOnly) && (file.write(contents) == contents.size()) && file.commit()) {
+        logger.info(Concern::Operation, QString("Almanac exported to \"%1\"").arg(filename));
+    } else {
+        logger.error(Concern::Operation, QString("Could not export the almanac to \"%1\": %2").arg(filename, file.errorString()));
+    }
+}
+
+void QAlmanacDialog::export_csv(void) {
+    this->save("CSV files (*.csv)", this->m_almanac.csv(this->m_nights).toUtf8());
+}
+
+void QAlmanacDialog::export_json(void) {
+    this->save("JSON files (*.json)", QJsonDocument(this->m_almanac.json(this->m_nights)).toJson());
+}
@@ -0,0 +1,53 @@
+#ifndef QALMANACDIALOG_H
+#define QALMANACDIALOG_H
+
+#include <QDialog>
+#include <QSpinBox>
+#include <QComboBox>
+#include <QPushButton>
+#include <QLabel>
+#include <QTableWidget>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+
+#include "utils/almanac.h"
+
+QT_FORWARD_DECLARE_CLASS(QStation);
+
+/**
+ * @brief The QAlmanacDialog class shows the nightly observation windows of the station for a whole year,
+ *        for the darkness limit of either camera, and exports them as CSV or JSON.
+ *        The almanac is computed in the background, the dialog stays responsive meanwhile.
+ */
+class QAlmanacDialog: public QDialog {
+    Q_OBJECT
+private:
+    const QStation * m_station;
+    Almanac m_almanac;
+    QVector<Almanac::Night> m_nights;
+
+    QSpinBox * m_year;
+    QComboBox * m_camera;
+    QPushButton * m_compute;
+    QPushButton * m_export_csv;
+    QPushButton * m_export_json;
+    QLabel * m_summary;
+    QTableWidget * m_table;
+
+    QFutureWatcher<QVector<Almanac::Night>> * m_watcher;
+    QElapsedTimer m_elapsed;
+
+    void display(void);
+    void save(const QString & filter, const QByteArray & contents);
+
+public:
+    explicit QAlmanacDialog(const QStation * station, QWidget * parent = nullptr);
+
+private slots:
+    void compute(void);
+    void computed(void);
+    void export_csv(void);
+    void export_json(void);
+};
+
+#endif // QALMANACDIALOG_H
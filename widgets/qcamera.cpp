@@ -14,15 +14,33 @@ QCamera::QCamera(QWidget * parent):
     QAmosWidget(parent),
     ui(new Ui::QCamera),
     m_id(""),
-    m_darkness_limit(QCamera::DefaultDarknessLimit)
+    m_darkness_limit(QCamera::DefaultDarknessLimit),
+    m_storage_thread(nullptr),
+    m_storage_worker(nullptr)
 {
     this->ui->setupUi(this);
 
     this->ui->sl_dome_open->set_title("Observation begins");
     this->ui->sl_dome_close->set_title("Observation ends");
+
+    this->m_storage_thread = new QThread(this);
+    this->m_storage_worker = new QStorageWorker();
+    this->m_storage_worker->moveToThread(this->m_storage_thread);
+    this->connect(this->m_storage_thread, &QThread::started, this->m_storage_worker, &QStorageWorker::initialize, Qt::QueuedConnection);
+    this->connect(this->m_storage_thread, &QThread::finished, this->m_storage_worker, &QObject::deleteLater);
+    this->connect(this, &QCamera::storage_requested, this->m_storage_worker, &QStorageWorker::move_sighting, Qt::QueuedConnection);
+    this->connect(this, &QCamera::discard_requested, this->m_storage_worker, &QStorageWorker::remove_sighting, Qt::QueuedConnection);
+    this->connect(this->m_storage_worker, &QStorageWorker::stored, this, &QCamera::handle_sighting_stored, Qt::QueuedConnection);
+    this->connect(this->m_storage_worker, &QStorageWorker::discarded, this, &QCamera::handle_sighting_discarded, Qt::QueuedConnection);
+    this->connect(this->m_storage_worker, &QStorageWorker::log, this, &QCamera::pass_log_message, Qt::QueuedConnection);
+    this->connect(this->m_storage_worker, &QStorageWorker::transfer_progress, this->ui->storage_primary, &QStorageBox::display_transfer, Qt::QueuedConnection);
+    this->m_storage_thread->start();
 }
 
 QCamera::~QCamera() {
+    // Jobs still queued are lost, the journal makes the model store them again after restart
+    this->m_storage_thread->quit();
+    this->m_storage_thread->wait();
     delete this->ui;
 }
 
@@ -165,30 +183,49 @@ bool QCamera::is_sighting_valid(const Sighting & sighting) const {
 }
 
 void QCamera::discard_sighting(Sighting & sighting) {
-    // Discard the sighting, even if it is invalid
-    try {
-        logger.debug(Concern::Sightings,
-                     QString("Camera '%1' about to discard sighting '%2'").arg(this->id(), sighting.prefix()));
-        this->ui->storage_primary->discard_sighting(sighting);
-        emit this->sighting_discarded(sighting);
-    } catch (RuntimeException & exc) {
-        logger.error(Concern::Sightings, exc.what());
+    // Discard the sighting, even if it is invalid, but only if it belongs to this camera
+    if (sighting.is_spectral() == this->is_spectral()) {
+        logger.warning(Concern::Sightings,
+                       QString("Camera '%1' discarding sighting '%2'").arg(this->id(), sighting.prefix()));
+        emit this->discard_requested(sighting.prefix(), sighting.present_files());
     }
 }
 
 void QCamera::store_sighting(Sighting & sighting) {
     if (this->is_sighting_valid(sighting)) {
-        try {
-            logger.debug(Concern::Sightings,
-                         QString("Camera '%1' about to store sighting '%2'").arg(this->id(), sighting.prefix()));
-            this->ui->storage_primary->store_sighting(sighting);
-            emit this->sighting_stored(sighting);
-        } catch (RuntimeException & exc) {
-            logger.error(Concern::Sightings, exc.what());
-        }
+        logger.debug(Concern::Sightings,
+                     QString("Camera '%1' about to store sighting '%2'").arg(this->id(), sighting.prefix()));
+        emit this->storage_requested(sighting.prefix(), sighting.present_files(),
+                                     this->ui->storage_primary->directory_for_sighting(sighting));
+    }
+}
+
+void QCamera::handle_sighting_stored(const QString & sighting_id, bool success) {
+    if (success) {
+        emit this->sighting_stored(sighting_id);
+    } else {
+        logger.error(Concern::Sightings, QString("Camera '%1' could not store sighting '%2'").arg(this->id(), sighting_id));
     }
 }
 
+void QCamera::handle_sighting_discarded(const QString & sighting_id, bool success) {
+    if (success) {
+        emit this->sighting_discarded(sighting_id);
+    } else {
+        logger.error(Concern::Sightings, QString("Camera '%1' could not discard sighting '%2'").arg(this->id(), sighting_id));
+    }
+}
+
+void QCamera::pass_log_message(Concern concern, Level level, const QString & message) {
+    logger.write(level, concern, message);
+}
+
+// Forget everything the scanner has already reported, so that all sightings are found again
+void QCamera::rescan_sightings(void) {
+    this->ui->scanner->reset_index();
+    this->ui->scanner->scan_incremental();
+}
+
 void QCamera::set_darkness_limit(double new_darkness_limit) {
     if ((new_darkness_limit < -18) || (new_darkness_limit > 0)) {
         throw ConfigurationError(QString("Darkness limit out of admissible range: %1°").arg(new_darkness_limit, 1, 'f', 1));
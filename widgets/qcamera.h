@@ -2,9 +2,11 @@
 #define QCAMERA_H
 
 #include <QGroupBox>
+#include <QThread>
 
 #include "widgets/qconfigurable.h"
 #include "utils/sighting.h"
+#include "utils/qstorageworker.h"
 
 QT_FORWARD_DECLARE_CLASS(QStation);
 
@@ -24,6 +26,10 @@ private:
 
     double m_darkness_limit;
 
+    // Sighting files are moved and deleted in a separate thread
+    QThread * m_storage_thread;
+    QStorageWorker * m_storage_worker;
+
     void connect_slots(void) override;
     void load_defaults(void) override;
     void load_settings_inner(void) override;
@@ -62,6 +68,10 @@ private slots:
 
     void on_dsb_darkness_limit_valueChanged(double value);
 
+    void handle_sighting_stored(const QString & sighting_id, bool success);
+    void handle_sighting_discarded(const QString & sighting_id, bool success);
+    void pass_log_message(Concern concern, Level level, const QString & message);
+
 public slots:
     void initialize(QSettings * settings, const QString & id, const QStation * const station, bool spectral);
     void auto_action(bool is_dark, const QDateTime & open_since = QDateTime());
@@ -69,14 +79,18 @@ public slots:
 
     void store_sighting(Sighting & sighting);
     void discard_sighting(Sighting & sighting);
+    void rescan_sightings(void);
 
 signals:
     void darkness_limit_changed(double new_limit);
 
     void sightings_scanned(void);
     void sighting_found(Sighting & sighting);
-    void sighting_stored(Sighting & sighting);
-    void sighting_discarded(Sighting & sighting);
+    void sighting_stored(const QString & sighting_id);
+    void sighting_discarded(const QString & sighting_id);
+
+    void storage_requested(const QString & sighting_id, const QStringList & files, const QString & directory);
+    void discard_requested(const QString & sighting_id, const QStringList & files);
 };
 
 #endif // QCAMERA_H
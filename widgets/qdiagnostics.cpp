@@ -0,0 +1,62 @@
+#include <QVBoxLayout>
+#include <QHeaderView>
+#include <QJsonValue>
+#include <QSet>
+#include <cmath>
+
+#include "widgets/qdiagnostics.h"
+
+
+QDiagnostics::QDiagnostics(QWidget * parent):
+    QWidget(parent)
+{
+    this->m_tree = new QTreeWidget(this);
+    this->m_tree->setColumnCount(2);
+    this->m_tree->setHeaderLabels({"Quantity", "Value"});
+    this->m_tree->header()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
+
+    QVBoxLayout * layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(this->m_tree);
+}
+
+void QDiagnostics::fill(QTreeWidgetItem * parent, const QJsonObject & values) {
+    for (auto item = values.constBegin(); item != values.constEnd(); ++item) {
+        QTreeWidgetItem * child = new QTreeWidgetItem(parent, {item.key()});
+        if (item.value().isObject()) {
+            QDiagnostics::fill(child, item.value().toObject());
+            child->setExpanded(true);
+        } else if (item.value().isDouble()) {
+            const double value = item.value().toDouble();
+            child->setText(1, (value == std::floor(value)) ? QString::number(static_cast<qint64>(value)) : QString::number(value, 'f', 3));
+        } else {
+            child->setText(1, item.value().toVariant().toString());
+        }
+    }
+}
+
+void QDiagnostics::display(const QString & section, const QJsonObject & values) {
+    QTreeWidgetItem * root = this->m_sections.value(section, nullptr);
+    if (root == nullptr) {
+        root = new QTreeWidgetItem(this->m_tree, {section});
+        this->m_sections.insert(section, root);
+    }
+
+    // Remember which subsections were collapsed by the user
+    QSet<QString> collapsed;
+    for (int i = 0; i < root->childCount(); ++i) {
+        if ((root->child(i)->childCount() > 0) && !root->child(i)->isExpanded()) {
+            collapsed.insert(root->child(i)->text(0));
+        }
+    }
+
+    qDeleteAll(root->takeChildren());
+    QDiagnostics::fill(root, values);
+
+    for (int i = 0; i < root->childCount(); ++i) {
+        if (collapsed.contains(root->child(i)->text(0))) {
+            root->child(i)->setExpanded(false);
+        }
+    }
+    root->setExpanded(true);
+}
@@ -0,0 +1,27 @@
+#ifndef QDIAGNOSTICS_H
+#define QDIAGNOSTICS_H
+
+#include <QWidget>
+#include <QTreeWidget>
+#include <QJsonObject>
+
+/**
+ * @brief The QDiagnostics class shows internal statistics of the client as a tree of sections,
+ *        every section is replaced as a whole whenever its owner publishes a new snapshot.
+ */
+class QDiagnostics: public QWidget {
+    Q_OBJECT
+private:
+    QTreeWidget * m_tree;
+    QMap<QString, QTreeWidgetItem *> m_sections;
+
+    static void fill(QTreeWidgetItem * parent, const QJsonObject & values);
+
+public:
+    explicit QDiagnostics(QWidget * parent = nullptr);
+
+public slots:
+    void display(const QString & section, const QJsonObject & values);
+};
+
+#endif // QDIAGNOSTICS_H
@@ -7,12 +7,14 @@
 #include "utils/request.h"
 #include "utils/telegram.h"
 #include "utils/formatters.h"
+#include "utils/metrics.h"
 #include "widgets/qstation.h"
 
 #include "qdome.h"
 #include "ui_qdome.h"
 
 extern EventLogger logger;
+extern Metrics metrics;
 
 
 const Command QDome::CommandNoOp                = Command('\x00', "no operation");
@@ -168,7 +170,8 @@ void QDome::connect_slots(void) {
     }
 
     this->connect(this, &QDome::serial_port_selected, this->m_spm, &QSerialPortManager::set_port, Qt::QueuedConnection);
-    this->connect(this, &QDome::command, this->m_spm, &QSerialPortManager::request, Qt::QueuedConnection);
+    this->connect(this, &QDome::command, this->m_spm, &QSerialPortManager::send_command, Qt::QueuedConnection);
+    this->connect(this, &QDome::servo_moving_changed, this->m_spm, &QSerialPortManager::set_servo_moving, Qt::QueuedConnection);
     this->connect(this->ui->pb_sw_reset, &QPushButton::pressed, this, &QDome::request_sw_reset);
     this->connect(this->ui->cb_enabled, &QCheckBox::checkStateChanged, this, &QDome::set_enabled);
     this->connect(this->ui->cb_enabled, &QCheckBox::checkStateChanged, this->m_spm, &QSerialPortManager::set_enabled, Qt::QueuedConnection);
@@ -181,6 +184,7 @@ void QDome::connect_slots(void) {
     this->connect(this->m_spm, &QSerialPortManager::port_changed, this, &QDome::handle_serial_port_changed, Qt::QueuedConnection);
     this->connect(this->m_spm, &QSerialPortManager::port_state_changed, this, &QDome::set_serial_port_state, Qt::QueuedConnection);
     this->connect(this->m_spm, &QSerialPortManager::log, this, &QDome::pass_log_message, Qt::QueuedConnection);
+    this->connect(this->m_spm, &QSerialPortManager::statistics_updated, this, &QDome::handle_link_statistics, Qt::QueuedConnection);
 }
 
 void QDome::load_defaults(void) {
@@ -529,6 +533,11 @@ void QDome::pass_log_message(Concern concern, Level level, const QString & messa
     logger.write(level, concern, message);
 }
 
+void QDome::handle_link_statistics(const QJsonObject & statistics) {
+    this->m_link_statistics = statistics;
+    emit this->link_statistics_updated("Dome link latency [ms]", statistics);
+}
+
 QJsonObject QDome::json(void) const {
     return QJsonObject {
         {"on", this->is_enabled()},
@@ -536,18 +545,37 @@ QJsonObject QDome::json(void) const {
         {"s", this->m_state_S.json()},
         {"t", this->m_state_T.json()},
         {"z", this->m_state_Z.json()},
+        {"lat", this->m_link_statistics},
     };
 }
 
 void QDome::send_command(const Command & command) {
+    static Metrics::Counter & commands = metrics.counter(Concern::SerialPort, "commands_sent");
+    commands.increment();
     logger.debug(Concern::SerialPort, QString("Sending a command '%1'").arg(command.display_name()));
     emit this->command(command.for_telegram());
 }
 
 void QDome::process_message(const QByteArray & message) {
+    static Metrics::Counter & state_S = metrics.counter(Concern::SerialPort, "states_received{state=\"S\"}");
+    static Metrics::Counter & state_T = metrics.counter(Concern::SerialPort, "states_received{state=\"T\"}");
+    static Metrics::Counter & state_Z = metrics.counter(Concern::SerialPort, "states_received{state=\"Z\"}");
+    static Metrics::Counter & invalid = metrics.counter(Concern::SerialPort, "states_invalid");
+
+    logger.debug(Concern::SerialPort, [&message] { return QString("New telegram: '%1'").arg(QString(message)); });
+    Telegram::Frame frame{};
+    const Telegram::Error error = Telegram::decode(message, frame);
+    if ((error != Telegram::Error::None) || (frame.length == 0)) {
+        invalid.increment();
+        logger.error(Concern::SerialPort, QString("Malformed message '%1': %2")
+                                              .arg(QString(message), error == Telegram::Error::None ? "empty payload" : Telegram::error_string(error)));
+        this->set_data_state("invalid data");
+        return;
+    }
+
     try {
-        Telegram telegram(message);
-        QByteArray decoded = telegram.get_message();
+        // The states copy what they need, so the payload does not have to leave the stack
+        const QByteArray decoded = QByteArray::fromRawData(frame.payload.data(), frame.length);
         this->m_last_received = QDateTime::currentDateTimeUtc();
 
         switch (decoded[0]) {
@@ -555,7 +583,10 @@ void QDome::process_message(const QByteArray & message) {
                 [[fallthrough]];
             case 'S':
                 this->m_state_S = DomeStateS(decoded);
+                state_S.increment();
+                this->export_state(this->m_state_S);
                 emit this->state_updated_S(this->m_state_S);
+                emit this->servo_moving_changed(this->m_state_S.servo_moving());
 
                 if (this->m_state_Z.is_valid()) {
                     if (this->m_state_S.dome_open_sensor_active()) {
@@ -569,6 +600,8 @@ void QDome::process_message(const QByteArray & message) {
                 break;
             case 'T':
                 this->m_state_T = DomeStateT(decoded);
+                state_T.increment();
+                this->export_state(this->m_state_T);
                 emit this->state_updated_T(this->m_state_T);
                 break;
 #if PROTOCOL == 2015
@@ -577,6 +610,8 @@ void QDome::process_message(const QByteArray & message) {
             case 'Z':
 #endif
                 this->m_state_Z = DomeStateZ(decoded);
+                state_Z.increment();
+                this->export_state(this->m_state_Z);
                 emit this->state_updated_Z(this->m_state_Z);
                 break;
             default:
@@ -584,14 +619,59 @@ void QDome::process_message(const QByteArray & message) {
         }
         this->set_data_state("valid data");
     } catch (MalformedTelegram & e) {
+        invalid.increment();
         logger.error(Concern::SerialPort, QString("Malformed message '%1'").arg(QString(message)));
         this->set_data_state("invalid data");
     } catch (InvalidState & e) {
+        invalid.increment();
         logger.error(Concern::SerialPort, QString("Invalid state message: '%1'").arg(e.what()));
         this->set_data_state("invalid data");
     }
 }
 
+/** Current readings as gauges, for the metrics endpoint **/
+
+void QDome::export_state(const DomeStateS & state) const {
+    static Metrics::Gauge & received = metrics.gauge(Concern::SerialPort, "dome_last_received_seconds");
+    static Metrics::Gauge & cover_open = metrics.gauge(Concern::SerialPort, "dome_sensor{sensor=\"cover_open\"}");
+    static Metrics::Gauge & cover_closed = metrics.gauge(Concern::SerialPort, "dome_sensor{sensor=\"cover_closed\"}");
+    static Metrics::Gauge & rain = metrics.gauge(Concern::SerialPort, "dome_sensor{sensor=\"rain\"}");
+    static Metrics::Gauge & light = metrics.gauge(Concern::SerialPort, "dome_sensor{sensor=\"light\"}");
+    static Metrics::Gauge & intensifier = metrics.gauge(Concern::SerialPort, "dome_device{device=\"intensifier\"}");
+    static Metrics::Gauge & fan = metrics.gauge(Concern::SerialPort, "dome_device{device=\"fan\"}");
+    static Metrics::Gauge & hotwire = metrics.gauge(Concern::SerialPort, "dome_device{device=\"hotwire\"}");
+    static Metrics::Gauge & errors = metrics.gauge(Concern::SerialPort, "dome_errors");
+    static Metrics::Gauge & alive = metrics.gauge(Concern::SerialPort, "dome_time_alive_seconds");
+
+    received.set(this->m_last_received.toMSecsSinceEpoch() / 1000.0);
+    cover_open.set(state.dome_open_sensor_active());
+    cover_closed.set(state.dome_closed_sensor_active());
+    rain.set(state.rain_sensor_active());
+    light.set(state.light_sensor_active());
+    intensifier.set(state.intensifier_active());
+    fan.set(state.fan_active());
+    hotwire.set(state.lens_heating_active());
+    errors.set(state.errors());
+    alive.set(state.time_alive());
+}
+
+void QDome::export_state(const DomeStateT & state) const {
+    static Metrics::Gauge & lens = metrics.gauge(Concern::SerialPort, "dome_temperature_celsius{sensor=\"lens\"}");
+    static Metrics::Gauge & cpu = metrics.gauge(Concern::SerialPort, "dome_temperature_celsius{sensor=\"cpu\"}");
+    static Metrics::Gauge & ambient = metrics.gauge(Concern::SerialPort, "dome_temperature_celsius{sensor=\"ambient\"}");
+    static Metrics::Gauge & humidity = metrics.gauge(Concern::SerialPort, "dome_humidity_percent");
+
+    lens.set(state.temperature_lens());
+    cpu.set(state.temperature_CPU());
+    ambient.set(state.temperature_sht());
+    humidity.set(state.humidity_sht());
+}
+
+void QDome::export_state(const DomeStateZ & state) const {
+    static Metrics::Gauge & shaft = metrics.gauge(Concern::SerialPort, "dome_shaft_position");
+    shaft.set(state.shaft_position());
+}
+
 /** Commands and their wrappers **/
 
 void QDome::toggle_hotwire(void) {
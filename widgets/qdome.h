@@ -47,7 +47,12 @@ private:
     DomeStateT m_state_T;
     DomeStateZ m_state_Z;
 
+    QJsonObject m_link_statistics;
+
     void process_message(const QByteArray & message);
+    void export_state(const DomeStateS & state) const;
+    void export_state(const DomeStateT & state) const;
+    void export_state(const DomeStateZ & state) const;
 
     void connect_slots(void) override;
     void load_defaults(void) override;
@@ -62,6 +67,7 @@ private:
     const static QString DefaultPort;
 
 private slots:
+    void handle_link_statistics(const QJsonObject & statistics);
     void send_command(const Command & command);
 
     void display_dome_state(void);
@@ -164,6 +170,8 @@ signals:
 
     void enabled_set(int enabled);
     void serial_port_selected(const QString & port);
+    void servo_moving_changed(bool moving);
+    void link_statistics_updated(const QString & section, const QJsonObject & statistics);
     void humidity_limits_changed(double new_lower, double new_upper);
 };
 
@@ -5,38 +5,47 @@
 #include "widgets/qstation.h"
 #include "widgets/qserver.h"
 #include "utils/exceptions.h"
+#include "utils/metrics.h"
+#include "utils/gzip.h"
 
 #include "ui_qserver.h"
 
 extern EventLogger logger;
+extern Metrics metrics;
 extern QSettings * settings;
 
 
 QServer::QServer(QWidget * parent):
     QAmosWidget(parent),
-    ui(new Ui::QServer)
+    ui(new Ui::QServer),
+    m_heartbeat_delta(false),
+    m_heartbeat_gzip(false),
+    m_backlog_in_flight(false),
+    m_backlog_delay(QServer::BacklogInterval)
 {
     this->ui->setupUi(this);
 
-    this->m_heartbeat_manager = new QNetworkAccessManager(this);
-    this->m_sighting_manager = new QNetworkAccessManager(this);
+    this->m_transport = new ServerTransport(this);
     this->connect(this->ui->bt_send_heartbeat, &QPushButton::clicked, this, &QServer::button_send_heartbeat);
     this->connect(this, &QServer::settings_saved, this, &QServer::refresh_urls);
-    this->connect(this->m_heartbeat_manager, &QNetworkAccessManager::finished, this, &QServer::heartbeat_finished);
-    this->connect(this->m_sighting_manager, &QNetworkAccessManager::finished, this, &QServer::sighting_received);
+    this->connect(this->m_transport, &ServerTransport::finished, this, &QServer::request_finished);
 
     this->m_timer_heartbeat = new QTimer(this);
     this->m_timer_heartbeat->setInterval(60000);
     this->m_timer_heartbeat->start();
+
+    this->m_heartbeat_buffer = new HeartbeatBuffer(this, "heartbeats.buffer");
+    this->m_timer_backlog = new QTimer(this);
+    this->m_timer_backlog->setSingleShot(true);
+    this->connect(this->m_timer_backlog, &QTimer::timeout, this, &QServer::send_backlog);
 }
 
 QServer::~QServer() {
     delete this->ui;
-    delete this->m_heartbeat_manager;
-    delete this->m_sighting_manager;
 }
 
 void QServer::initialize(QSettings * settings) {
+    this->m_heartbeat_buffer->initialize();
     QAmosWidget::initialize(settings);
     this->refresh_urls();
 }
@@ -49,6 +58,12 @@ void QServer::connect_slots(void) {
 }
 
 void QServer::load_settings_inner(void) {
+    // Before the address, so that the connection is pre-warmed with the right protocol
+    this->set_transport(
+        this->m_settings->value("server/tls", false).toBool(),
+        ServerTransport::parse_http2(this->m_settings->value("server/http2", "auto").toString()),
+        this->m_settings->value("server/pipelining", false).toBool()
+    );
     this->set_station_id(
         this->m_settings->value("station/id", "none").toString()
     );
@@ -59,13 +74,23 @@ void QServer::load_settings_inner(void) {
     this->set_heartbeat_interval(
         this->m_settings->value("server/interval", 60).toInt()
     );
+    this->set_heartbeat_encoding(
+        this->m_settings->value("server/heartbeat_delta", false).toBool(),
+        this->m_settings->value("server/heartbeat_gzip", false).toBool(),
+        this->m_settings->value("server/keyframe_interval", HeartbeatEncoder::DefaultKeyframeInterval).toInt()
+    );
+    this->m_heartbeat_buffer->set_capacity(
+        this->m_settings->value("server/buffer_size", HeartbeatBuffer::DefaultCapacity).toInt()
+    );
     this->refresh_urls();
 }
 
 void QServer::load_defaults(void) {
+    this->set_transport(false, ServerTransport::Http2::Auto, false);
     this->set_station_id("none");
     this->set_address("127.0.0.1", 4805);
     this->set_heartbeat_interval(60);
+    this->set_heartbeat_encoding(false, false, HeartbeatEncoder::DefaultKeyframeInterval);
 }
 
 void QServer::save_settings_inner(void) const {
@@ -73,6 +98,13 @@ void QServer::save_settings_inner(void) const {
     this->m_settings->setValue("server/ip", this->address().toString());
     this->m_settings->setValue("server/port", this->port());
     this->m_settings->setValue("server/interval", this->heartbeat_interval());
+    this->m_settings->setValue("server/heartbeat_delta", this->m_heartbeat_delta);
+    this->m_settings->setValue("server/heartbeat_gzip", this->m_heartbeat_gzip);
+    this->m_settings->setValue("server/keyframe_interval", this->m_heartbeat_encoder.keyframe_interval());
+    this->m_settings->setValue("server/buffer_size", this->m_heartbeat_buffer->capacity());
+    this->m_settings->setValue("server/tls", this->m_transport->is_tls());
+    this->m_settings->setValue("server/http2", ServerTransport::http2_name(this->m_transport->http2()));
+    this->m_settings->setValue("server/pipelining", this->m_transport->is_pipelining());
 }
 
 void QServer::set_address(const QString & address, const unsigned short port) {
@@ -84,6 +116,7 @@ void QServer::set_address(const QString & address, const unsigned short port) {
     this->m_address = addr;
     this->m_port = port;
     this->refresh_urls();
+    this->m_transport->prewarm(this->m_address, this->m_port);
 
     QString full_address = QString("%1:%2").arg(this->m_address.toString()).arg(this->m_port);
     logger.info(Concern::Server, QString("Address set to %1").arg(full_address));
@@ -109,19 +142,56 @@ void QServer::set_heartbeat_interval(unsigned int interval) {
     this->m_timer_heartbeat->start();
 }
 
+/**
+ * @brief QServer::set_transport
+ * @param tls           use HTTPS instead of plain HTTP
+ * @param http2         when to use HTTP/2, see ServerTransport::Http2
+ * @param pipelining    allow HTTP/1.1 pipelining
+ */
+void QServer::set_transport(bool tls, ServerTransport::Http2 http2, bool pipelining) {
+    this->m_transport->configure(tls, http2, pipelining);
+    this->refresh_urls();
+    logger.info(Concern::Server, QString("Transport set to %1, HTTP/2 %2%3")
+                                     .arg(this->m_transport->scheme(), ServerTransport::http2_name(http2), pipelining ? ", pipelining" : ""));
+}
+
+/**
+ * @brief QServer::set_heartbeat_encoding
+ * @param delta                 send only the fields changed since the last accepted heartbeat
+ * @param gzip                  compress the request body
+ * @param keyframe_interval     send a full heartbeat every this many heartbeats
+ */
+void QServer::set_heartbeat_encoding(bool delta, bool gzip, int keyframe_interval) {
+    this->m_heartbeat_delta = delta;
+    this->m_heartbeat_gzip = gzip;
+    this->m_heartbeat_encoder.set_keyframe_interval(keyframe_interval);
+    this->m_heartbeat_encoder.reset();
+    logger.info(Concern::Server, QString("Heartbeat encoding set to %1%2")
+                                     .arg(delta ? QString("delta, keyframe every %1").arg(keyframe_interval) : "full",
+                                          gzip ? ", gzip" : ""));
+}
 
 void QServer::refresh_urls(void) {
     this->m_url_heartbeat = QUrl(
-        QString("http://%1:%2/station/%3/heartbeat/")
+        QString("%4://%1:%2/station/%3/heartbeat/")
+            .arg(this->m_address.toString())
+            .arg(this->m_port)
+            .arg(this->m_station_id)
+            .arg(this->m_transport->scheme())
+    );
+    this->m_url_backlog = QUrl(
+        QString("%4://%1:%2/station/%3/heartbeats/")
             .arg(this->m_address.toString())
             .arg(this->m_port)
             .arg(this->m_station_id)
+            .arg(this->m_transport->scheme())
     );
     this->m_url_sighting = QUrl(
-        QString("http://%1:%2/station/%3/sighting/")
+        QString("%4://%1:%2/station/%3/sighting/")
             .arg(this->m_address.toString())
             .arg(this->m_port)
             .arg(this->m_station_id)
+            .arg(this->m_transport->scheme())
     );
 }
 
@@ -131,15 +201,47 @@ void QServer::send_heartbeat(const QJsonObject & heartbeat) const {
     QNetworkRequest request(this->m_url_heartbeat);
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
 
-    QByteArray message = QJsonDocument(heartbeat).toJson(QJsonDocument::Compact);
-    logger.debug(Concern::Heartbeat, QString("Heartbeat assembled: '%1'").arg(QString(message)));
+    bool keyframe = true;
+    const QJsonObject encoded = this->m_heartbeat_delta ? this->m_heartbeat_encoder.encode(heartbeat, keyframe) : heartbeat;
+    QByteArray message = QJsonDocument(encoded).toJson(QJsonDocument::Compact);
+    logger.debug(Concern::Heartbeat, [&] {
+        return QString("Heartbeat assembled (%1): '%2'").arg(keyframe ? "full" : "delta", QString(message));
+    });
+
+    if (this->m_heartbeat_gzip) {
+        message = Gzip::compress(message);
+        request.setRawHeader("Content-Encoding", "gzip");
+    }
 
-    QNetworkReply * reply = this->m_heartbeat_manager->post(request, message);
+    static Metrics::Counter & sent = metrics.counter(Concern::Heartbeat, "sent");
+    static Metrics::Counter & deltas = metrics.counter(Concern::Heartbeat, "deltas_sent");
+    static Metrics::Counter & bytes = metrics.counter(Concern::Heartbeat, "bytes_sent");
+    QNetworkReply * reply = this->m_transport->post(request, message, "heartbeat");
+    reply->setProperty("sent_at", QDateTime::currentMSecsSinceEpoch());
+    // The full heartbeat becomes the base for the following deltas once accepted, or is buffered if not
+    reply->setProperty("heartbeat", heartbeat);
+    reply->setProperty("keyframe", keyframe);
+    if (!keyframe) {
+        deltas.increment();
+    }
     this->connect(reply, &QNetworkReply::errorOccurred, this, &QServer::heartbeat_error);
+    sent.increment();
+    bytes.increment(message.size());
 
     this->m_last_heartbeat = QDateTime::currentDateTimeUtc();
 }
 
+// All requests share one connection pool, dispatch the replies by what they carried
+void QServer::request_finished(QNetworkReply * reply) {
+    if (reply->property("sighting").isValid()) {
+        this->sighting_received(reply);
+    } else if (reply->property("backlog").isValid()) {
+        this->backlog_finished(reply);
+    } else {
+        this->heartbeat_finished(reply);
+    }
+}
+
 void QServer::heartbeat_error(QNetworkReply::NetworkError error) {
     auto reply = static_cast<QNetworkReply *>(sender());
     logger.error(
@@ -153,9 +255,25 @@ void QServer::heartbeat_error(QNetworkReply::NetworkError error) {
 }
 
 void QServer::heartbeat_finished(QNetworkReply * reply) {
+    static Metrics::Counter & accepted = metrics.counter(Concern::Heartbeat, "accepted");
+    static Metrics::Counter & failed = metrics.counter(Concern::Heartbeat, "failed");
+    static Metrics::Histogram & duration = metrics.histogram(Concern::Heartbeat, "round_trip_seconds");
     reply->deleteLater();
-
-    if (reply->error() == QNetworkReply::NoError) {
+    duration.observe((QDateTime::currentMSecsSinceEpoch() - reply->property("sent_at").toLongLong()) / 1000.0);
+
+    const QVariant heartbeat = reply->property("heartbeat");
+    if (reply->error() != QNetworkReply::NoError) {
+        failed.increment();
+        if (!reply->property("keyframe").toBool()) {
+            // The server may not have the base of the delta, start over from a full heartbeat
+            this->m_heartbeat_encoder.reset();
+        }
+        this->buffer_heartbeat(reply);
+    } else {
+        accepted.increment();
+        this->m_heartbeat_encoder.acknowledge(heartbeat.toJsonObject());
+        // The server is reachable again, catch up on what it missed
+        this->schedule_backlog(this->m_backlog_delay);
         logger.debug(
             Concern::Server,
             QString("Heartbeat accepted (HTTP code %1), response \"%2\"").arg(
@@ -167,26 +285,142 @@ void QServer::heartbeat_finished(QNetworkReply * reply) {
     }
 }
 
+/**
+ * @brief QServer::buffer_heartbeat
+ * Keeps a heartbeat that did not reach the server for the backlog. Full heartbeats that the server
+ * refused (HTTP 4xx except timeouts and throttling) would be refused again and are not kept.
+ * A refused delta is kept, the server has probably lost its base and the backlog carries the full heartbeat.
+ */
+void QServer::buffer_heartbeat(QNetworkReply * reply) {
+    static Metrics::Counter & buffered = metrics.counter(Concern::Heartbeat, "buffered");
+    static Metrics::Counter & dropped = metrics.counter(Concern::Heartbeat, "buffer_overflows");
+    static Metrics::Gauge & waiting = metrics.gauge(Concern::Heartbeat, "backlog");
+
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (reply->property("keyframe").toBool() && (status >= 400) && (status < 500) && (status != 408) && (status != 429)) {
+        return;
+    }
+
+    const int before = this->m_heartbeat_buffer->dropped();
+    this->m_heartbeat_buffer->append(reply->property("heartbeat").toJsonObject());
+    buffered.increment();
+    dropped.increment(this->m_heartbeat_buffer->dropped() - before);
+    waiting.set(this->m_heartbeat_buffer->count());
+    logger.debug(Concern::Heartbeat, QString("Heartbeat buffered, %1 waiting").arg(this->m_heartbeat_buffer->count()));
+}
+
+// Only one batch is ever in flight, the next one is scheduled when the previous one is accepted
+void QServer::schedule_backlog(int delay) {
+    if (!this->m_heartbeat_buffer->is_empty() && !this->m_backlog_in_flight && !this->m_timer_backlog->isActive()) {
+        this->m_timer_backlog->start(delay);
+    }
+}
+
+/**
+ * @brief QServer::send_backlog
+ * Uploads the oldest buffered heartbeats as a single request
+ * {"protocol": ..., "heartbeats": [...]} of full heartbeats, oldest first
+ */
+void QServer::send_backlog(void) {
+    int count = 0;
+    qint64 end = 0;
+    const QByteArray batch = this->m_heartbeat_buffer->batch(QServer::BacklogBatchCount, QServer::BacklogBatchSize, count, end);
+    if (count == 0) {
+        return;
+    }
+
+    QByteArray message = QString("{\"protocol\":%1,\"heartbeats\":").arg(HEARTBEAT_PROTOCOL_VERSION).toUtf8() + batch + '}';
+    QNetworkRequest request(this->m_url_backlog);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    if (this->m_heartbeat_gzip) {
+        message = Gzip::compress(message);
+        request.setRawHeader("Content-Encoding", "gzip");
+    }
+
+    logger.debug(Concern::Heartbeat, QString("Uploading %1 buffered heartbeats (%2 left) to %3")
+                                         .arg(count).arg(this->m_heartbeat_buffer->count() - count).arg(this->m_url_backlog.toString()));
+    QNetworkReply * reply = this->m_transport->post(request, message, "backlog");
+    reply->setProperty("backlog", count);
+    reply->setProperty("backlog_end", end);
+    this->m_backlog_in_flight = true;
+}
+
+/**
+ * @brief QServer::backlog_finished
+ * An accepted batch is removed and the next one follows shortly. After a failure the pause
+ * doubles and the upload resumes only after the next accepted live heartbeat, or after the time
+ * the server asked for with Retry-After. A batch the server refuses outright is dropped.
+ */
+void QServer::backlog_finished(QNetworkReply * reply) {
+    static Metrics::Counter & uploaded = metrics.counter(Concern::Heartbeat, "backlog_uploaded");
+    static Metrics::Counter & refused = metrics.counter(Concern::Heartbeat, "backlog_refused");
+    static Metrics::Gauge & waiting = metrics.gauge(Concern::Heartbeat, "backlog");
+    reply->deleteLater();
+    this->m_backlog_in_flight = false;
+
+    // Live heartbeats may have pushed some of the batch out of a full buffer in the meantime
+    const int count = reply->property("backlog").toInt();
+    const qint64 end = reply->property("backlog_end").toLongLong();
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (reply->error() == QNetworkReply::NoError) {
+        this->m_heartbeat_buffer->remove_until(end);
+        uploaded.increment(count);
+        this->m_backlog_delay = QServer::BacklogInterval;
+        logger.info(Concern::Heartbeat, QString("Uploaded %1 buffered heartbeats, %2 left").arg(count).arg(this->m_heartbeat_buffer->count()));
+        this->schedule_backlog(this->m_backlog_delay);
+    } else if ((status >= 400) && (status < 500) && (status != 408) && (status != 429)) {
+        this->m_heartbeat_buffer->remove_until(end);
+        refused.increment(count);
+        logger.error(Concern::Heartbeat, QString("Server refused %1 buffered heartbeats (HTTP code %2), dropping them: %3")
+                                             .arg(count).arg(status).arg(QString(reply->readAll())));
+        this->schedule_backlog(this->m_backlog_delay);
+    } else {
+        bool ok = false;
+        const int retry_after = reply->rawHeader("Retry-After").toInt(&ok);
+        this->m_backlog_delay = ok ? qBound(QServer::BacklogInterval, retry_after * 1000, QServer::BacklogMaxDelay)
+                                   : qMin(this->m_backlog_delay * 2, QServer::BacklogMaxDelay);
+        logger.warning(Concern::Heartbeat, QString("Could not upload buffered heartbeats (%1), pausing for %2 s")
+                                               .arg(reply->errorString()).arg(this->m_backlog_delay / 1000));
+    }
+    waiting.set(this->m_heartbeat_buffer->count());
+}
+
 void QServer::send_sighting(const Sighting & sighting) const {
     logger.debug(Concern::Server, QString("Sending sighting '%1' to %2").arg(sighting.prefix(), this->m_url_sighting.toString()));
 
+    // File parts are streamed from disk: the files are owned by the multipart and read as the socket drains
     QHttpMultiPart * multipart = new QHttpMultiPart(QHttpMultiPart::FormDataType);
-    multipart->append(sighting.jpg_part());
-    multipart->append(sighting.xml_part());
+    multipart->append(sighting.jpg_part(multipart));
+    multipart->append(sighting.xml_part(multipart));
     multipart->append(sighting.json());
 
     QNetworkRequest request(this->m_url_sighting);
-    QNetworkReply * reply = this->m_sighting_manager->post(request, multipart);
+    static Metrics::Counter & uploads = metrics.counter(Concern::Server, "sighting_uploads");
+    QNetworkReply * reply = this->m_transport->post(request, multipart, "sighting");
     reply->setProperty("sighting", sighting.prefix());
+    reply->setProperty("sent_at", QDateTime::currentMSecsSinceEpoch());
+    uploads.increment();
     multipart->setParent(reply); // delete the multipart with the reply
 
     emit this->sighting_sent(sighting.prefix());
 }
 
 void QServer::sighting_received(QNetworkReply * reply) {
+    reply->deleteLater();
+
+    // Release the streamed files now, the sighting is about to be moved or deleted
+    for (QFile * file: reply->findChildren<QFile *>()) {
+        file->close();
+    }
+
     QString sighting_id = reply->property("sighting").toString();
     QNetworkReply::NetworkError error = reply->error();
 
+    static Metrics::Histogram & duration = metrics.histogram(Concern::Server, "sighting_upload_seconds");
+    static Metrics::Counter & accepted = metrics.counter(Concern::Server, "sighting_responses{result=\"accepted\"}");
+    static Metrics::Counter & conflict = metrics.counter(Concern::Server, "sighting_responses{result=\"conflict\"}");
+    static Metrics::Counter & failed = metrics.counter(Concern::Server, "sighting_responses{result=\"error\"}");
+    duration.observe((QDateTime::currentMSecsSinceEpoch() - reply->property("sent_at").toLongLong()) / 1000.0);
     switch (error) {
         case QNetworkReply::NoError: {
             // OK, accepted by the server
@@ -201,6 +435,7 @@ void QServer::sighting_received(QNetworkReply * reply) {
                 Concern::Server,
                 QString("Response \"%3\"").arg(QString(reply->readAll()))
             );
+            accepted.increment();
             emit this->sighting_accepted(sighting_id);
             break;
         }
@@ -214,6 +449,7 @@ void QServer::sighting_received(QNetworkReply * reply) {
                     .arg(reply->errorString())
                     .arg(QString(reply->readAll()))
             );
+            conflict.increment();
             emit this->sighting_conflict(sighting_id);
             break;
         }
@@ -226,6 +462,7 @@ void QServer::sighting_received(QNetworkReply * reply) {
                     .arg(reply->errorString())
                     .arg(QString(reply->readAll()))
             );
+            failed.increment();
             emit this->sighting_error(sighting_id, error);
             break;
         }
@@ -237,6 +474,7 @@ void QServer::sighting_received(QNetworkReply * reply) {
                     .arg(reply->error())
                     .arg(reply->errorString())
             );
+            failed.increment();
             emit this->sighting_error(sighting_id, error);
             break;
         }
@@ -249,6 +487,7 @@ void QServer::sighting_received(QNetworkReply * reply) {
                     .arg(reply->error())
                     .arg(reply->errorString())
             );
+            failed.increment();
             emit this->sighting_error(sighting_id, error);
             break;
         }
@@ -8,6 +8,9 @@
 
 #include "widgets/qconfigurable.h"
 #include "utils/sighting.h"
+#include "utils/heartbeatencoder.h"
+#include "utils/heartbeatbuffer.h"
+#include "utils/servertransport.h"
 
 namespace Ui {
     class QServer;
@@ -18,8 +21,7 @@ class QServer: public QAmosWidget {
     Q_OBJECT
 private:
     Ui::QServer * ui;
-    QNetworkAccessManager * m_heartbeat_manager;
-    QNetworkAccessManager * m_sighting_manager;
+    ServerTransport * m_transport;
 
     QTimer * m_timer_heartbeat;
     mutable QDateTime m_last_heartbeat;
@@ -29,7 +31,24 @@ private:
     QString m_station_id;
     int m_heartbeat_interval;
 
+    // Optional heartbeat protocol extensions, the server must support them
+    bool m_heartbeat_delta;
+    bool m_heartbeat_gzip;
+    mutable HeartbeatEncoder m_heartbeat_encoder;
+
+    // Heartbeats that could not be delivered, uploaded in batches one at a time once the server is back
+    HeartbeatBuffer * m_heartbeat_buffer;
+    QTimer * m_timer_backlog;
+    bool m_backlog_in_flight;
+    int m_backlog_delay;
+
+    constexpr static int BacklogInterval = 2000;            // Time in ms: pause between two accepted batches
+    constexpr static int BacklogMaxDelay = 600000;          // Time in ms: longest pause after failed batches
+    constexpr static int BacklogBatchCount = 60;            // Number of heartbeats in one batch at most
+    constexpr static qint64 BacklogBatchSize = 256 << 10;   // Size in bytes of one batch at most, before compression
+
     QUrl m_url_heartbeat;
+    QUrl m_url_backlog;
     QUrl m_url_sighting;
 
     void connect_slots(void) override;
@@ -48,8 +67,14 @@ private slots:
     void set_station_id(const QString & station_id);
     void set_heartbeat_interval(unsigned int interval);
 
+    void request_finished(QNetworkReply * reply);
     void heartbeat_error(QNetworkReply::NetworkError error);
     void heartbeat_finished(QNetworkReply * reply);
+    void buffer_heartbeat(QNetworkReply * reply);
+
+    void schedule_backlog(int delay);
+    void send_backlog(void);
+    void backlog_finished(QNetworkReply * reply);
     void refresh_urls(void);
 
     void on_le_station_id_textChanged(const QString & text);
@@ -69,6 +94,10 @@ public:
     inline const int & heartbeat_interval(void) const { return this->m_heartbeat_interval; }
 
     inline const QTimer * timer_heartbeat(void) const { return this->m_timer_heartbeat; }
+    inline const ServerTransport * transport(void) const { return this->m_transport; }
+
+    void set_heartbeat_encoding(bool delta, bool gzip, int keyframe_interval);
+    void set_transport(bool tls, ServerTransport::Http2 http2, bool pipelining);
 
 public slots:
     void initialize(QSettings * settings) override;
@@ -45,7 +45,10 @@ void QSightingBuffer::handle_sightings_scanned(void) {
 
 void QSightingBuffer::display_time(void) {
     this->ui->lb_reloaded->setText(
-        QString("reloaded <b>%1 s</b> ago")
+        QString("reloaded <b>%1 s</b> ago, queue <b>%2</b>, in flight <b>%3</b>, <b>%4</b>/min")
             .arg(static_cast<double>((QDateTime::currentDateTimeUtc() - this->m_last_data).count()) / 1000.0, 0, 'f', 1)
+            .arg(this->m_sighting_model->queue_depth())
+            .arg(this->m_sighting_model->in_flight())
+            .arg(this->m_sighting_model->throughput(), 0, 'f', 1)
     );
 }
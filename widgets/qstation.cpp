@@ -5,9 +5,11 @@
 #include "ui_qstation.h"
 #include "utils/universe.h"
 #include "utils/exceptions.h"
+#include "utils/metrics.h"
 
 extern EventLogger logger;
 extern QSettings * settings;
+extern Metrics metrics;
 
 
 const StationState QStation::Daylight           = StationState('D', "daylight", Icon::Daylight, "not observing: too light");
@@ -55,6 +57,8 @@ QStation::QStation(QWidget * parent):
 
     this->m_state_logger = new StateLogger(this, "state.log");
     this->m_state_logger->initialize();
+    this->m_binary_state_logger = new BinaryStateLogger(this, "state");
+    this->m_binary_state_logger->initialize();
 
     this->m_timer_automatic = new QTimer(this);
     this->m_timer_automatic->setInterval(1000);
@@ -64,11 +68,16 @@ QStation::QStation(QWidget * parent):
 
 QStation::~QStation() {
     delete this->m_state_logger;
+    delete this->m_binary_state_logger;
     delete ui;
 }
 
 void QStation::initialize(QSettings * settings) {
     QAmosWidget::initialize(settings);
+    this->m_state_logger->set_rotation(
+        settings->value("logging/max_size", BaseLogger::DefaultMaxSize).toLongLong(),
+        settings->value("logging/retention", BaseLogger::DefaultRetention).toLongLong()
+    );
 }
 
 void QStation::connect_slots(void) {
@@ -195,14 +204,14 @@ double QStation::moon_azimuth(const QDateTime & time) const {
 }
 
 /* Compute next crossing of the Sun through the almucantar `altitude` in the specified direction (up/down)
- * with resolution of `resolution` seconds (optional, default = 60) */
-QDateTime QStation::next_sun_crossing(double altitude, bool direction_up, int resolution) const {
-    return Universe::next_crossing(Universe::sun_altitude, this->latitude(), this->longitude(), altitude, direction_up, resolution);
+ * within the next 24 hours, accurate to Universe::CrossingAccuracy */
+QDateTime QStation::next_sun_crossing(double altitude, bool direction_up) const {
+    return Universe::next_crossing(Universe::sun_altitude, this->latitude(), this->longitude(), altitude, direction_up);
 }
 
 /* The same with the Moon */
-QDateTime QStation::next_moon_crossing(double altitude, bool direction_up, int resolution) const {
-    return Universe::next_crossing(Universe::moon_altitude, this->latitude(), this->longitude(), altitude, direction_up, resolution);
+QDateTime QStation::next_moon_crossing(double altitude, bool direction_up) const {
+    return Universe::next_crossing(Universe::moon_altitude, this->latitude(), this->longitude(), altitude, direction_up);
 }
 
 void QStation::automatic_timer(void) {
@@ -212,6 +221,8 @@ void QStation::automatic_timer(void) {
 
 // Perform automatic state checks
 void QStation::automatic_cover(void) {
+    static Metrics::Counter & runs = metrics.counter(Concern::Automatic, "cover_loops");
+    runs.increment();
     logger.debug(Concern::Automatic, "Automatic cover action");
     const DomeStateS & stateS = this->dome()->state_S();
 
@@ -333,6 +344,7 @@ QJsonObject QStation::json(void) const {
         {"cv", VERSION_STRING},
 #endif
         {"cs", this->start_time().toString(Qt::ISODate)},
+        {"mtr", metrics.json()},
     };
 }
 
@@ -350,6 +362,8 @@ void QStation::send_heartbeat(void) const {
 
 void QStation::set_state(StationState new_state) {
     if (new_state != this->m_state) {
+        static Metrics::Counter & changes = metrics.counter(Concern::Operation, "state_changes");
+        changes.increment();
         logger.info(Concern::Operation, QString("State changed from \"%1\" to \"%2\"")
                      .arg(this->state().display_string(), new_state.display_string()));
         this->m_state = new_state;
@@ -358,9 +372,33 @@ void QStation::set_state(StationState new_state) {
 }
 
 void QStation::log_state(void) const {
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    const double sun_altitude = this->sun_altitude(now);
     this->m_state_logger->log(QString("%1° %2 %3")
-                              .arg(this->sun_altitude(), 5, 'f', 1)
+                              .arg(sun_altitude, 5, 'f', 1)
                               .arg(QString(QChar(this->state().code())), this->dome()->status_line()));
+
+    const DomeStateS & state_S = this->dome()->state_S();
+    const DomeStateT & state_T = this->dome()->state_T();
+    const DomeStateZ & state_Z = this->dome()->state_Z();
+
+    StateRecord record;
+    record.timestamp = now.toMSecsSinceEpoch();
+    record.sun_altitude = StateRecord::deci(sun_altitude);
+    record.state = static_cast<char>(this->state().code());
+    record.valid = (state_S.is_valid() ? StateRecord::ValidS : 0) |
+                   (state_T.is_valid() ? StateRecord::ValidT : 0) |
+                   (state_Z.is_valid() ? StateRecord::ValidZ : 0);
+    record.basic = state_S.basic();
+    record.env = state_S.env();
+    record.errors = state_S.errors();
+    record.time_alive = state_S.time_alive();
+    record.temperature_sht = StateRecord::deci(state_T.temperature_sht());
+    record.temperature_lens = StateRecord::deci(state_T.temperature_lens());
+    record.temperature_cpu = StateRecord::deci(state_T.temperature_CPU());
+    record.humidity = StateRecord::deci(state_T.humidity_sht());
+    record.shaft_position = state_Z.shaft_position();
+    this->m_binary_state_logger->log(record);
 }
 
 /*********************** Event handlers ***********************************/
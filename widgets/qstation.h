@@ -11,6 +11,7 @@
 #include "widgets/qcamera.h"
 
 #include "logging/statelogger.h"
+#include "logging/binarystatelogger.h"
 
 namespace Ui {
     class QStation;
@@ -32,6 +33,7 @@ private:
 
     StationState m_state;
     StateLogger * m_state_logger;
+    BinaryStateLogger * m_binary_state_logger;
 
     // Pointers to subordinate widgets
     QDome * m_dome;
@@ -113,8 +115,8 @@ public:
     double sun_azimuth(const QDateTime & time = QDateTime::currentDateTimeUtc()) const;
     double moon_altitude(const QDateTime & time = QDateTime::currentDateTimeUtc()) const;
     double moon_azimuth(const QDateTime & time = QDateTime::currentDateTimeUtc()) const;
-    QDateTime next_sun_crossing(double altitude, bool direction_up, int resolution = 60) const;
-    QDateTime next_moon_crossing(double altitude, bool direction_up, int resolution = 60) const;
+    QDateTime next_sun_crossing(double altitude, bool direction_up) const;
+    QDateTime next_moon_crossing(double altitude, bool direction_up) const;
 
     inline QString state_logger_filename(void) const { return this->m_state_logger->filename(); };
     inline StationState state(void) const { return this->m_state; };
@@ -5,6 +5,7 @@
 #include "utils/formatters.h"
 #include "utils/universe.h"
 #include "widgets/qstation.h"
+#include "widgets/qalmanacdialog.h"
 
 extern EventLogger logger;
 
@@ -136,3 +137,8 @@ void QSunInfo::update_long_term(void) {
     this->ui->dtl_moonrise->set_value(this->m_station->next_moon_crossing(-0.5, true));
     this->ui->dtl_moonset->set_value(this->m_station->next_moon_crossing(-0.5, false));
 }
+
+void QSunInfo::on_bt_almanac_clicked(void) {
+    QAlmanacDialog dialog(this->m_station, this);
+    dialog.exec();
+}
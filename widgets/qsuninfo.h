@@ -29,6 +29,9 @@ public:
 public slots:
     void update_short_term(void);
     void update_long_term(void);
+
+private slots:
+    void on_bt_almanac_clicked(void);
 };
 
 #endif // QSUNINFO_H
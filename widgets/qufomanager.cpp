@@ -10,6 +10,7 @@
 
 extern EventLogger logger;
 extern QSettings * settings;
+extern Metrics metrics;
 
 const UfoState QUfoManager::Unknown      = UfoState('U', "unknown", Qt::black, false, "Error");
 const UfoState QUfoManager::NotAnExe     = UfoState('E', "not an EXE file", Qt::red, false, "Error");
@@ -29,7 +30,8 @@ QUfoManager::QUfoManager(QWidget * parent):
     m_path(""),
     m_id(""),
     m_autostart(false),
-    m_state(QUfoManager::NotRunning)
+    m_state(QUfoManager::NotRunning),
+    m_gauge_running(nullptr)
 {
     ui->setupUi(this);
 
@@ -55,6 +57,7 @@ void QUfoManager::initialize(const QString & id) {
         throw ConfigurationError("UFO manager id already set");
     }
     this->m_id = id;
+    this->m_gauge_running = &metrics.gauge(Concern::UFO, QString("running{ufo=\"%1\"}").arg(id));
 
     this->load_settings();
     this->update_state();
@@ -119,7 +122,7 @@ void QUfoManager::auto_action(bool is_dark, const QDateTime & open_since) {
 }
 
 void QUfoManager::update_state(void) {
-    logger.debug(Concern::UFO, QString("UFO-%1: Updating state...").arg(this->id()));
+    logger.debug(Concern::UFO, [this] { return QString("UFO-%1: Updating state...").arg(this->id()); });
 
     this->disconnect(this->ui->bt_toggle, &QPushButton::clicked, nullptr, nullptr);
 
@@ -151,7 +154,7 @@ void QUfoManager::update_state(void) {
             break;
         }
     }
-    logger.debug(Concern::UFO, QString("UFO-%1 state is %2").arg(this->id(), new_ufo_state.display_string()));
+    logger.debug(Concern::UFO, [&] { return QString("UFO-%1 state is %2").arg(this->id(), new_ufo_state.display_string()); });
 
     this->ui->lb_state->setText(new_ufo_state.display_string());
     this->ui->lb_state->setStyleSheet(QString("QLabel { color: %1; }").arg(new_ufo_state.colour().name()));
@@ -159,6 +162,10 @@ void QUfoManager::update_state(void) {
     this->ui->bt_toggle->setText(new_ufo_state.button_text());
     this->ui->cb_auto->setEnabled(new_ufo_state.button_enabled());
 
+    if (this->m_gauge_running != nullptr) {
+        this->m_gauge_running->set(new_ufo_state == QUfoManager::Running);
+    }
+
     if (new_ufo_state != this->m_state) {
         this->m_state = new_ufo_state;
         emit this->state_changed(new_ufo_state);
@@ -206,7 +213,7 @@ void QUfoManager::start_ufo_inner(void) {
 
     Sleep(QUfoManager::SleepTime);
     this->m_frame = FindWindowA(nullptr, "UFOCapture");
-    logger.debug(Concern::UFO, QString("UFO-%1 HWND is %2").arg(this->id()).arg((long long) this->m_frame));
+    logger.debug(Concern::UFO, [this] { return QString("UFO-%1 HWND is %2").arg(this->id()).arg((long long) this->m_frame); });
     Sleep(QUfoManager::SleepTime);
     ShowWindowAsync(this->m_frame, SW_SHOWMINIMIZED);
     this->m_start_scheduled = false;
@@ -220,7 +227,7 @@ void QUfoManager::start_ufo_inner(void) {
  */
 void QUfoManager::stop_ufo(void) {
     if (this->m_process.state() == QProcess::ProcessState::NotRunning) {
-        logger.debug(Concern::UFO, QString("UFO-%1: Not running").arg(this->id()));
+        logger.debug(Concern::UFO, [this] { return QString("UFO-%1: Not running").arg(this->id()); });
     } else {
         HWND child;
 
@@ -7,6 +7,7 @@
 #include "windows.h"
 #include "winuser.h"
 #include "utils/state/ufostate.h"
+#include "utils/metrics.h"
 
 
 QT_FORWARD_DECLARE_CLASS(QStation);
@@ -32,6 +33,7 @@ private:
 
     bool m_autostart;
     UfoState m_state;
+    Metrics::Gauge * m_gauge_running;
     void update_state(void);
 
     void start_ufo_inner(void);
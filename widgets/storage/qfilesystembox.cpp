@@ -6,6 +6,7 @@
 
 extern EventLogger logger;
 extern QSettings * settings;
+extern Metrics metrics;
 
 QFileSystemBox::QFileSystemBox(QWidget * parent):
     QGroupBox(parent),
@@ -55,6 +56,8 @@ void QFileSystemBox::initialize(const QString & camera, const QString & id, cons
     this->m_camera = camera;
     this->m_id = id;
     this->m_default_path = default_path;
+    this->m_gauge_available = &metrics.gauge(Concern::Storage, QString("available_bytes{storage=\"%1\"}").arg(this->full_id()));
+    this->m_gauge_total = &metrics.gauge(Concern::Storage, QString("total_bytes{storage=\"%1\"}").arg(this->full_id()));
 
     this->load_settings(settings);
     this->scan_info();
@@ -135,6 +138,11 @@ void QFileSystemBox::scan_info(void) {
     double total = (double) info.bytesTotal() / (1 << 30);
     double used = (double) info.bytesAvailable() / (1 << 30);
 
+    if (this->m_gauge_available != nullptr) {
+        this->m_gauge_available->set(info.bytesAvailable());
+        this->m_gauge_total->set(info.bytesTotal());
+    }
+
     this->m_pb_capacity->setRange(0, (unsigned int) total);
     this->m_pb_capacity->setValue((unsigned int) (total - used));
     this->m_pb_capacity->setStyleSheet(
@@ -15,6 +15,7 @@
 
 #include "logging/eventlogger.h"
 #include "utils/sighting.h"
+#include "utils/metrics.h"
 
 
 class QFileSystemBox: public QGroupBox {
@@ -44,6 +45,10 @@ protected:
 
     QTimer * m_timer;
 
+    // Registered once the id is known, until then the scan is not exported
+    Metrics::Gauge * m_gauge_available = nullptr;
+    Metrics::Gauge * m_gauge_total = nullptr;
+
     void select_directory(void);
 
 public:
@@ -59,7 +64,7 @@ public:
 
 public slots:
     void initialize(const QString & camera, const QString & id, const QString & default_path);
-    void load_settings(const QSettings * const settings);
+    virtual void load_settings(const QSettings * const settings);
     //void save_settings(QSettings * settings) const;
 
     void scan_info(void);
@@ -6,6 +6,7 @@
 
 
 extern EventLogger logger;
+extern QSettings * settings;
 
 QString QScannerBox::DialogTitle(void) const { return "Select UFO output directory to watch"; }
 QString QScannerBox::AbortMessage(void) const { return "Watch directory selection aborted"; }
@@ -13,9 +14,89 @@ QString QScannerBox::MessageEnabled(void) const { return "Scanner \"%1\" %2abled
 QString QScannerBox::MessageDirectoryChanged(void) const { return "Scanner \"%1\" set to \"%2\""; }
 
 QScannerBox::QScannerBox(QWidget * parent):
-    QFileSystemBox(parent)
+    QFileSystemBox(parent),
+    m_incremental(QScannerBox::DefaultIncremental)
 {
-    this->connect(this->m_timer, &QTimer::timeout, this, &QScannerBox::scan_sightings);
+    this->connect(this->m_timer, &QTimer::timeout, this, &QScannerBox::tick);
+
+    // Several files are written for every sighting, so wait until the directory settles down
+    this->m_timer_settle = new QTimer(this);
+    this->m_timer_settle->setInterval(QScannerBox::SettleInterval);
+    this->m_timer_settle->setSingleShot(true);
+    this->connect(this->m_timer_settle, &QTimer::timeout, this, &QScannerBox::scan_incremental);
+
+    this->m_timer_reconcile = new QTimer(this);
+    this->m_timer_reconcile->setInterval(QScannerBox::ReconcileInterval);
+    this->connect(this->m_timer_reconcile, &QTimer::timeout, this, &QScannerBox::scan_incremental);
+    this->m_timer_reconcile->start();
+
+    this->m_watcher = new QFileSystemWatcher(this);
+    this->connect(this->m_watcher, &QFileSystemWatcher::directoryChanged, this->m_timer_settle, QOverload<>::of(&QTimer::start));
+}
+
+QString QScannerBox::incremental_key(void) const {
+    return QString("camera_%1/%2_incremental").arg(((QCamera *) this->parentWidget())->id(), this->id());
+}
+
+void QScannerBox::load_settings(const QSettings * const settings) {
+    this->m_incremental = settings->value(this->incremental_key(), QScannerBox::DefaultIncremental).toBool();
+    QFileSystemBox::load_settings(settings);
+}
+
+void QScannerBox::set_directory(const QDir & new_directory) {
+    QFileSystemBox::set_directory(new_directory);
+    this->reset_index();
+    this->rewatch();
+}
+
+void QScannerBox::set_enabled(bool enabled) {
+    QFileSystemBox::set_enabled(enabled);
+    this->rewatch();
+}
+
+void QScannerBox::set_incremental(bool incremental) {
+    logger.info(Concern::Storage, QString("Scanner \"%1\" set to %2 mode").arg(this->full_id(), incremental ? "incremental" : "full"));
+
+    this->m_incremental = incremental;
+    this->reset_index();
+    this->rewatch();
+    settings->setValue(this->incremental_key(), incremental);
+}
+
+/**
+ * @brief QScannerBox::rewatch
+ * Point the file system watcher to the current directory, or stop watching if not needed
+ */
+void QScannerBox::rewatch(void) {
+    if (!this->m_watcher->directories().isEmpty()) {
+        this->m_watcher->removePaths(this->m_watcher->directories());
+    }
+
+    if (this->is_enabled() && this->is_incremental()) {
+        if (this->m_directory.exists()) {
+            this->m_watcher->addPath(this->m_directory.canonicalPath());
+            logger.debug(Concern::Storage, QString("Scanner \"%1\" watching %2").arg(this->full_id(), this->m_directory.canonicalPath()));
+        } else {
+            logger.warning(Concern::Storage, QString("Scanner \"%1\" cannot watch %2, directory does not exist")
+                                                 .arg(this->full_id(), this->m_directory.path()));
+        }
+        this->m_timer_settle->start();
+    }
+}
+
+void QScannerBox::reset_index(void) {
+    this->m_known.clear();
+}
+
+void QScannerBox::tick(void) {
+    if (this->is_incremental()) {
+        // The watcher does not notice a directory that appears later, keep trying
+        if (this->is_enabled() && this->m_watcher->directories().isEmpty() && this->m_directory.exists()) {
+            this->rewatch();
+        }
+    } else {
+        this->scan_sightings();
+    }
 }
 
 void QScannerBox::scan_sightings(void) {
@@ -46,3 +127,53 @@ void QScannerBox::scan_sightings(void) {
     }
     emit this->sightings_scanned();
 }
+
+/**
+ * @brief QScannerBox::scan_incremental
+ * List the directory once and create Sightings only for prefixes that are not in the index yet.
+ * Prefixes that disappeared (stored or discarded) are dropped from the index,
+ * prefixes that could not be turned into a Sighting are retried on the next change.
+ */
+void QScannerBox::scan_incremental(void) {
+    if (!this->is_incremental()) {
+        return;
+    }
+
+    if (this->is_enabled()) {
+        QVector<Sighting> sightings;
+        QSet<QString> present;
+
+        QString dir = this->m_directory.canonicalPath();
+        logger.debug(Concern::Storage, QString("Incrementally scanning %1 (%2 known)").arg(dir).arg(this->m_known.count()));
+
+        const QStringList xmls = this->m_directory.entryList({"M*.xml"}, QDir::Filter::NoDotAndDotDot | QDir::Filter::Files);
+
+        for (const QString & xml: xmls) {
+            QFileInfo xml_info(QString("%1/%2").arg(dir, xml));
+            const QString prefix = xml_info.completeBaseName();
+            present.insert(prefix);
+
+            if (this->m_known.contains(prefix)) {
+                continue;
+            }
+
+            try {
+                sightings.append(Sighting(xml_info.absolutePath(), prefix,
+                                          (static_cast<QCamera *>(this->parentWidget()))->is_spectral()));
+                this->m_known.insert(prefix);
+            } catch (RuntimeException & e) {
+                logger.error(Concern::Sightings, QString("Could not create a sighting: %1").arg(e.what()));
+            }
+        }
+
+        this->m_known.intersect(present);
+
+        if (sightings.count() > 0) {
+            logger.debug(Concern::Sightings, QString("%1 new sightings found").arg(sightings.count()));
+            emit this->sightings_found(sightings);
+        }
+    } else {
+        logger.debug(Concern::Storage, "Scanner disabled, not scanning");
+    }
+    emit this->sightings_scanned();
+}
@@ -1,11 +1,16 @@
 #ifndef QSCANNERBOX_H
 #define QSCANNERBOX_H
 
+#include <QSet>
+#include <QFileSystemWatcher>
+
 #include "widgets/storage/qfilesystembox.h"
 
 /**
  * @brief The QScannerBox class scans the specified directory for new files,
  *        and if anything is found, it emits a `sightings_found` signal.
+ *        In incremental mode the directory is watched for changes and only sightings
+ *        that were not seen before are emitted; a periodic full sweep reconciles the index.
  */
 class QScannerBox: public QFileSystemBox {
     Q_OBJECT
@@ -15,9 +20,39 @@ protected:
     virtual QString MessageEnabled(void) const override;
     virtual QString MessageDirectoryChanged(void) const override;
 
+    constexpr static unsigned int SettleInterval = 500;         // Time in ms: wait for UFO to finish writing files
+    constexpr static unsigned int ReconcileInterval = 60000;    // Time in ms: full sweep in case the watcher missed something
+    constexpr static bool DefaultIncremental = true;
+
+    QString incremental_key(void) const;
+
+    bool m_incremental;
+    QFileSystemWatcher * m_watcher;
+    QTimer * m_timer_settle;
+    QTimer * m_timer_reconcile;
+
+    // Prefixes of sightings that were already emitted and are still present in the directory
+    QSet<QString> m_known;
+
+    void rewatch(void);
+
+private slots:
+    void tick(void);
+
 public:
     explicit QScannerBox(QWidget * parent = nullptr);
+
+    inline bool is_incremental(void) const { return this->m_incremental; }
+
+public slots:
+    void load_settings(const QSettings * const settings) override;
+    void set_directory(const QDir & new_directory) override;
+    void set_enabled(bool enabled) override;
+    void set_incremental(bool incremental);
+
     void scan_sightings(void);
+    void scan_incremental(void);
+    void reset_index(void);
 
 signals:
     void sightings_scanned(void);
@@ -1,5 +1,6 @@
 #include <QJsonObject>
 #include "qstoragebox.h"
+#include "utils/formatters.h"
 
 extern EventLogger logger;
 extern QSettings * settings;
@@ -11,25 +12,40 @@ QString QStorageBox::MessageDirectoryChanged(void) const { return "Storage \"%1\
 
 QStorageBox::QStorageBox(QWidget * parent):
     QFileSystemBox(parent)
-{}
+{
+    this->m_lb_transfer = new QLabel(this);
+    this->m_lb_transfer->setVisible(false);
+    this->m_layout->addWidget(this->m_lb_transfer, 2, 1, 1, 3);
+}
+
+// Show the progress of a cross-volume copy, hide it when finished
+void QStorageBox::display_transfer(qint64 done, qint64 total, double rate) {
+    if (done >= total) {
+        this->m_lb_transfer->setVisible(false);
+        return;
+    }
+
+    const double eta = (rate > 0) ? (total - done) / rate : 0;
+    this->m_lb_transfer->setText(
+        QString("copying %1 / %2 MB, %3 MB/s, ETA %4")
+            .arg(done / 1048576.0, 0, 'f', 1)
+            .arg(total / 1048576.0, 0, 'f', 1)
+            .arg(rate / 1048576.0, 0, 'f', 1)
+            .arg(rate > 0 ? Formatters::format_duration_double(eta) : "unknown")
+    );
+    this->m_lb_transfer->setVisible(true);
+}
 
 const QDir QStorageBox::directory_for_timestamp(const QDateTime & datetime) const {
     return QDir(QString("%1/%2/").arg(this->m_directory.path(), datetime.toString("yyyy/MM/dd")));
 }
 
-void QStorageBox::store_sighting(Sighting & sighting) const {
-    logger.debug(Concern::Storage, QString("Storage \"%1\" storing a sighting").arg(this->id()));
+QString QStorageBox::directory_for_sighting(const Sighting & sighting) const {
 #if SEPARATE_SIGHTINGS
-    QString path = QString("%1/%2").arg(this->current_directory().path(), sighting.prefix());
+    return QString("%1/%2").arg(this->current_directory().path(), sighting.prefix());
 #else
-    QString path = this->directory_for_timestamp(sighting.timestamp()).path();
+    return this->directory_for_timestamp(sighting.timestamp()).path();
 #endif
-    sighting.move(path);
-}
-
-void QStorageBox::discard_sighting(Sighting & sighting) const {
-    logger.debug(Concern::Storage, QString("Storage \"%1\" discarding a sighting").arg(this->id()));
-    sighting.discard();
 }
 
 QJsonObject QStorageBox::json(void) const {
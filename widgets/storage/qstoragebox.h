@@ -1,6 +1,8 @@
 #ifndef QSTORAGEBOX_H
 #define QSTORAGEBOX_H
 
+#include <QLabel>
+
 #include "widgets/storage/qfilesystembox.h"
 #include "utils/sighting.h"
 
@@ -12,17 +14,16 @@ protected:
     virtual QString MessageEnabled(void) const override;
     virtual QString MessageDirectoryChanged(void) const override;
 
+    QLabel * m_lb_transfer;
+
 public:
     explicit QStorageBox(QWidget * parent = nullptr);
     QJsonObject json(void) const;
     const QDir directory_for_timestamp(const QDateTime & datetime = QDateTime::currentDateTimeUtc()) const;
+    QString directory_for_sighting(const Sighting & sighting) const;
 
 public slots:
-    void store_sighting(Sighting & sighting) const;
-    void discard_sighting(Sighting & sighting) const;
-
-signals:
-    void sighting_stored(const QString & name);
+    void display_transfer(qint64 done, qint64 total, double rate);
 };
 
 #endif // QSTORAGEBOX_H